@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+# Copyright 2020
+#
+# This file is part of WarpX.
+#
+# License: BSD-3-Clause-LBNL
+
+# This file is part of the WarpX automated test suite. It checks that, with
+# warpx.use_counter_rng = 1, the random numbers do not depend on the
+# decomposition of the domain.
+#
+# - Run the same simulation (random plasma positions, at initialization and
+#   with the continuous injection of a moving window) twice: with one box
+#   and large tiles, and with 4 boxes of 4 tiles each
+# - Check that the particle data of both runs are identical (the particles
+#   are sorted by position, since their ids and order depend on the boxes)
+
+import yt ; yt.funcs.mylog.setLevel(50)
+import numpy as np
+import glob
+import os
+
+species = 'electrons'
+last_step = 40
+
+decompositions = {
+    'large_tiles' : 'amr.max_grid_size=32 particles.tile_size=1024 1024',
+    'small_tiles' : 'amr.max_grid_size=16 particles.tile_size=8 8'
+}
+
+def get_particle_data(plotfile):
+    ds = yt.load( plotfile )
+    ad = ds.all_data()
+    data = np.array([ ad[species, 'particle_' + name].to_ndarray() for name in
+        ['position_x', 'position_y', 'momentum_x', 'momentum_y', 'momentum_z', 'weight'] ])
+    # Sort the particles by z, then x
+    order = np.lexsort( (data[0], data[1]) )
+    return data[:, order]
+
+def launch_analysis(executable):
+    data = {}
+    for name, params in decompositions.items():
+        os.system("./" + executable + " inputs_2d amr.plot_file=diags/" + name + "/plt " + params)
+        data[name] = get_particle_data( "diags/" + name + "/plt%05d" % last_step )
+
+    n_large, n_small = data['large_tiles'].shape[1], data['small_tiles'].shape[1]
+    print("Number of particles (large/small tiles): ", n_large, n_small)
+    assert( n_large > 0 )
+    assert( n_large == n_small )
+    assert( np.array_equal(data['large_tiles'], data['small_tiles']) )
+
+
+def main() :
+    executables = glob.glob("main2d*")
+    if len(executables) == 1 :
+        launch_analysis(executables[0])
+    else :
+        assert(False)
+    print('Passed')
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,49 @@
+#! /usr/bin/env python
+
+# Copyright 2020
+#
+# This file is part of WarpX.
+#
+# License: BSD-3-Clause-LBNL
+
+# This script tests the lossy compression of the plotfile fields
+# (compression.fields). The setup is a 2D nodal Langmuir wave, in which
+# Ex (absolute tolerance) and Ez (relative tolerance) are compressed.
+# The compressed fields are decoded with Tools/read_compressed_fields.py
+# and compared with the raw fields of the same plotfile
+# (warpx.plot_raw_fields = 1), averaged to the cell centers:
+# the error must stay within the tolerance of each field.
+
+import sys
+import numpy as np
+import read_raw_data
+from read_compressed_fields import read_compressed_fields
+
+# Tolerances, as in the runtime parameters of the test
+abs_tol = {'Ex' : 1.e6}
+rel_tol = {'Ez' : 1.e-4}
+# Margin for the round-off errors of the averaging to the cell centers
+round_off = 1.e-12
+
+fn = sys.argv[1]
+
+raw = read_raw_data.read_data(fn)[0]
+compressed, info = read_compressed_fields(fn)
+compressed = compressed[0]
+
+assert( sorted(compressed.keys()) == ['Ex', 'Ez'] )
+
+for field in ['Ex', 'Ez']:
+    # The fields are nodal (warpx.do_nodal = 1): average them to the cell centers
+    nodal = raw[field + '_aux']
+    reference = 0.25*( nodal[:-1,:-1] + nodal[1:,:-1] + nodal[:-1,1:] + nodal[1:,1:] )
+    decoded = compressed[field]
+    assert( decoded.shape == reference.shape )
+    assert( not np.any(np.isnan(decoded)) )
+
+    field_max = np.max(np.abs(reference))
+    assert( field_max > 0. )
+    tolerance = abs_tol[field] if field in abs_tol else rel_tol[field]*field_max
+    error = np.max(np.abs(decoded - reference))
+    print('max error on ' + field + ': ', error, ' (tolerance: ', tolerance, ')')
+    assert( error <= tolerance + round_off*field_max )
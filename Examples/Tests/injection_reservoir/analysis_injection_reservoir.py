@@ -0,0 +1,58 @@
+#! /usr/bin/env python
+
+# Copyright 2020
+#
+# This file is part of WarpX.
+#
+# License: BSD-3-Clause-LBNL
+
+# This script tests the injection reservoir of the continuous injection
+# (<species_name>.use_injection_reservoir). The setup is a moving window
+# entering a uniform plasma, with two identical species that are neither
+# pushed nor deposited: "direct" is injected as usual (AddPlasma), and
+# "reservoir" is copied from the reservoir into the layers inside the plasma.
+# At the end, the window only contains injected particles: both species must
+# have the same number of particles and the same weight moments.
+
+# Tolerance: 1.0e-10 (relative)
+
+import sys
+import yt
+import numpy as np
+
+tolerance = 1.0e-10
+
+fn = sys.argv[1]
+ds = yt.load( fn )
+ad = ds.all_data()
+
+# Size of the domain, used as scale for the position moments
+length = np.max( ds.domain_right_edge.v - ds.domain_left_edge.v )
+
+def get_moments( species ):
+    w  = ad[species, 'particle_weight'].to_ndarray()
+    x  = ad[species, 'particle_position_x'].to_ndarray()
+    z  = ad[species, 'particle_position_y'].to_ndarray()
+    ux = ad[species, 'particle_momentum_x'].to_ndarray()
+    uz = ad[species, 'particle_momentum_z'].to_ndarray()
+    moments = np.array([ np.sum(w), np.sum(w*x)/length, np.sum(w*z)/length,
+                         np.sum(w*x**2)/length**2, np.sum(w*z**2)/length**2,
+                         np.sum(w*ux), np.sum(w*uz) ])
+    return moments, w.size
+
+moments_direct, np_direct = get_moments( 'direct' )
+moments_reservoir, np_reservoir = get_moments( 'reservoir' )
+
+print('number of particles (direct/reservoir): ', np_direct, np_reservoir)
+assert( np_direct > 0 )
+assert( np_reservoir == np_direct )
+
+names = ['weight', 'x', 'z', 'x^2', 'z^2', 'momentum_x', 'momentum_z']
+for name, m_direct, m_reservoir in zip(names, moments_direct, moments_reservoir):
+    # Scale: total weight for the weight and position moments,
+    # and the moment itself for the momenta (which are not zero)
+    scale = moments_direct[0] if name in ['weight', 'x', 'z', 'x^2', 'z^2'] \
+            else abs(m_direct)
+    error = abs(m_reservoir - m_direct)/scale
+    print('relative error on the ' + name + ' moment: ', error)
+    assert( error < tolerance )
@@ -0,0 +1,55 @@
+#! /usr/bin/env python
+
+# Copyright 2020
+#
+# This file is part of WarpX.
+#
+# License: BSD-3-Clause-LBNL
+
+# This script tests the merging of macroparticles (resampling).
+# The setup is a uniform plasma with 200 electrons per cell, which are
+# merged at the first step into at most 40 electrons per cell.
+# The particles are not pushed, so the total weight, momentum and energy
+# of the electrons must be the same before (first plotfile) and after
+# (last plotfile) the merging.
+
+# Tolerance: 1.0e-10 (relative)
+
+import sys
+import yt
+import numpy as np
+import scipy.constants as scc
+
+tolerance = 1.0e-10
+ncells = 8*8
+target_ppc = 40
+
+def get_totals( fn ):
+    ds = yt.load( fn )
+    ad = ds.all_data()
+    w  = ad['electrons','particle_weight'].to_ndarray()
+    px = ad['electrons','particle_momentum_x'].to_ndarray()
+    py = ad['electrons','particle_momentum_y'].to_ndarray()
+    pz = ad['electrons','particle_momentum_z'].to_ndarray()
+    energy = np.sqrt((px**2+py**2+pz**2)*scc.c**2+scc.m_e**2*scc.c**4)
+    totals = np.array([ np.sum(w), np.sum(w*px), np.sum(w*py), np.sum(w*pz),
+                        np.sum(w*energy) ])
+    return totals, np.count_nonzero(w)
+
+first_fn = 'plt00000'
+last_fn = sys.argv[1]
+
+totals_0, np_0 = get_totals( first_fn )
+totals_1, np_1 = get_totals( last_fn )
+
+print('number of particles before/after: ', np_0, np_1)
+assert( np_1 < np_0 )
+assert( np_1 <= target_ppc*ncells )
+
+# Weight, momentum (x, y, z) and energy
+names = ['weight', 'momentum_x', 'momentum_y', 'momentum_z', 'energy']
+scales = [ totals_0[0], totals_0[4]/scc.c, totals_0[4]/scc.c, totals_0[4]/scc.c, totals_0[4] ]
+for name, t0, t1, scale in zip(names, totals_0, totals_1, scales):
+    error = abs(t1 - t0)/scale
+    print('relative error on the total ' + name + ': ', error)
+    assert( error < tolerance )
@@ -10,6 +10,7 @@
 
 #include "BackTransformedDiagnostic.H"
 #include "SliceDiagnostic.H"
+#include "FieldIO.H"
 #include "WarpX.H"
 
 using namespace amrex;
@@ -149,170 +150,176 @@ namespace
     }
 
     /*
-      Creates a group associated with a single particle species.
-      Should be run by all processes collectively.
+      Opens the output file with MPI-IO, for collective operations.
+      The returned handle is kept open across buffer flushes, and closed
+      with H5Fclose (which is collective as well).
+      Should be run on all ranks collectively.
     */
-    void output_create_species_group(const std::string& file_path, const std::string& species_name)
+    hid_t output_open(const std::string& file_path)
     {
-        MPI_Comm comm = MPI_COMM_WORLD;
-        MPI_Info info = MPI_INFO_NULL;
-        int mpi_rank;
-        MPI_Comm_rank(comm, &mpi_rank);
+        BL_PROFILE("output_open");
 
         // Create the file access prop list.
         hid_t pa_plist = H5Pcreate(H5P_FILE_ACCESS);
-        H5Pset_fapl_mpio(pa_plist, comm, info);
+        H5Pset_fapl_mpio(pa_plist, MPI_COMM_WORLD, MPI_INFO_NULL);
 
-        // Open the output.
         hid_t file = H5Fopen(file_path.c_str(), H5F_ACC_RDWR, pa_plist);
+        if (file < 0) {
+            amrex::Abort("Error: could not open file at " + file_path);
+        }
 
-        hid_t group = H5Gcreate(file, species_name.c_str(),
-                                H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-        H5Gclose(group);
-        H5Fclose(file);
-
+        H5Pclose(pa_plist);
+        return file;
     }
 
     /*
-      Resize an extendible dataset, suitable for storing particle data.
-      Should be run only by the master rank.
+      Writes count datasets in one operation, using the transfer prop list
+      xfer_plist. With HDF5 >= 1.14, this is a single multi-dataset
+      (collective) write, otherwise one write per dataset.
     */
-    long output_resize_particle_field(const std::string& file_path, const std::string& field_path,
-                                      const long num_to_add)
+    herr_t output_write_multi(const std::size_t count, hid_t* datasets, hid_t* mem_types,
+                              hid_t* mem_spaces, hid_t* file_spaces, const hid_t xfer_plist,
+                              const void** bufs)
     {
-        BL_PROFILE("output_resize_particle_field");
-
-        // Open the output.
-        hid_t file = H5Fopen(file_path.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
-
-        int rank;
-        hsize_t dims[1];
-
-        hid_t dataset = H5Dopen2 (file, field_path.c_str(), H5P_DEFAULT);
-        hid_t filespace = H5Dget_space (dataset);
-        rank = H5Sget_simple_extent_ndims (filespace);
-        herr_t status = H5Sget_simple_extent_dims (filespace, dims, NULL);
-
-        // set new size
-        hsize_t new_size[1];
-        new_size[0] = dims[0] + num_to_add;
-        status = H5Dset_extent (dataset, new_size);
-
-        if (status < 0)
-        {
-            amrex::Abort("Error: set extent filed on dataset "
-                         + std::to_string(dataset) + "\n");
+#if H5_VERSION_GE(1,14,0)
+        return H5Dwrite_multi(count, datasets, mem_types, mem_spaces, file_spaces,
+                              xfer_plist, bufs);
+#else
+        herr_t status = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            status = H5Dwrite(datasets[i], mem_types[i], mem_spaces[i], file_spaces[i],
+                              xfer_plist, bufs[i]);
+            if (status < 0) return status;
         }
-
-        // Close resources.
-        H5Sclose(filespace);
-        H5Dclose(dataset);
-        H5Fclose(file);
-
-        return dims[0];
+        return status;
+#endif
     }
 
     /*
-      Writes to a dataset that has been extended to the proper size. Suitable for writing particle data.
-      Should be run on all ranks collectively.
+      Opens the dataset field_path of the open file, and aborts if it is not there.
     */
-    void output_write_particle_field(const std::string& file_path, const std::string& field_path,
-                                     const Real* data_ptr, const long count, const long index)
+    hid_t output_open_dataset(hid_t file, const std::string& field_path)
     {
-        BL_PROFILE("output_write_particle_field");
-
-        MPI_Comm comm = MPI_COMM_WORLD;
-        MPI_Info info = MPI_INFO_NULL;
-        int mpi_rank;
-        MPI_Comm_rank(comm, &mpi_rank);
-
-        // Create the file access prop list.
-        hid_t pa_plist = H5Pcreate(H5P_FILE_ACCESS);
-        H5Pset_fapl_mpio(pa_plist, comm, info);
-
-        // Open the output.
-        hid_t file = H5Fopen(file_path.c_str(), H5F_ACC_RDWR, pa_plist);
-
-        int RANK = 1;
-        hsize_t offset[1];
-        hsize_t dims[1];
-        herr_t status;
-
-        hid_t dataset = H5Dopen (file, field_path.c_str(), H5P_DEFAULT);
+        hid_t dataset = H5Dopen(file, field_path.c_str(), H5P_DEFAULT);
 
         // Make sure the dataset is there.
         if (dataset < 0)
         {
-            amrex::Abort("Error on rank " + std::to_string(mpi_rank) +
+            amrex::Abort("Error on rank " + std::to_string(ParallelDescriptor::MyProc()) +
                          ". Count not find dataset " + field_path + "\n");
         }
+        return dataset;
+    }
 
-        hid_t filespace = H5Dget_space (dataset);
-
-        offset[0] = index;
-        dims[0] = count;
-
-        // Create collective io prop list.
-        hid_t collective_plist = H5Pcreate(H5P_DATASET_XFER);
-        H5Pset_dxpl_mpio(collective_plist, H5FD_MPIO_INDEPENDENT);
-
-        if (count > 0) {
+    /*
+      Creates a group associated with a single particle species.
+      Should be run by all processes collectively.
+    */
+    void output_create_species_group(hid_t file, const std::string& species_name)
+    {
+        hid_t group = H5Gcreate(file, species_name.c_str(),
+                                H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        H5Gclose(group);
+    }
 
-            /* Define memory space */
-            hid_t memspace = H5Screate_simple (RANK, dims, NULL);
+    /*
+      Appends count values to each of the extendible particle datasets
+      species_name/particle_field_names[k], at offset index from the current end
+      of the datasets, and extends them by total_np. data_ptrs[k] contains the
+      values of the field k.
+      The datasets are extended and all the fields are written in one collective
+      operation, so this should be run on all ranks collectively, with the same
+      total_np.
+    */
+    void output_write_particle_fields(hid_t file, const std::string& species_name,
+                                      const std::vector<const Real*>& data_ptrs,
+                                      const long count, const long index,
+                                      const long total_np)
+    {
+        BL_PROFILE("output_write_particle_fields");
 
-            status = H5Sselect_hyperslab (filespace, H5S_SELECT_SET, offset, NULL,
-                                          dims, NULL);
+        const std::size_t nfields = particle_field_names.size();
+        std::vector<hid_t> datasets(nfields), file_spaces(nfields), mem_spaces(nfields);
+        std::vector<hid_t> mem_types(nfields, H5T_NATIVE_DOUBLE);
+        std::vector<const void*> bufs(nfields);
 
+        // Dummy buffer for the ranks that have nothing to write.
+        const double dummy = 0.;
+        hsize_t offset[1];
+        hsize_t dims[1];
+        for (std::size_t k = 0; k < nfields; ++k)
+        {
+            datasets[k] = output_open_dataset(file, species_name + "/" + particle_field_names[k]);
+
+            // All the datasets of the species have the same size,
+            // which is identical on all ranks.
+            hid_t filespace = H5Dget_space(datasets[k]);
+            hsize_t old_dims[1];
+            H5Sget_simple_extent_dims(filespace, old_dims, NULL);
+            H5Sclose(filespace);
+
+            // Extend the dataset (collective).
+            hsize_t new_size[1];
+            new_size[0] = old_dims[0] + total_np;
+            herr_t status = H5Dset_extent(datasets[k], new_size);
             if (status < 0)
             {
-                amrex::Abort("Error on rank " + std::to_string(ParallelDescriptor::MyProc()) +
-                             " could not select hyperslab.\n");
+                amrex::Abort("Error: set extent filed on dataset "
+                             + species_name + "/" + particle_field_names[k] + "\n");
             }
-
-            /* Write the data to the extended portion of dataset  */
-            status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, memspace,
-                              filespace, collective_plist, data_ptr);
-
-            if (status < 0)
-            {
-                amrex::Abort("Error on rank " + std::to_string(ParallelDescriptor::MyProc()) +
-                             " could not write hyperslab.\n");
+            file_spaces[k] = H5Dget_space(datasets[k]);
+
+            offset[0] = old_dims[0] + index;
+            dims[0] = (count > 0) ? count : 1;
+            mem_spaces[k] = H5Screate_simple(1, dims, NULL);
+            if (count > 0) {
+                dims[0] = count;
+                status = H5Sselect_hyperslab(file_spaces[k], H5S_SELECT_SET, offset, NULL,
+                                             dims, NULL);
+                if (status < 0)
+                {
+                    amrex::Abort("Error on rank " + std::to_string(ParallelDescriptor::MyProc()) +
+                                 " could not select hyperslab.\n");
+                }
+                bufs[k] = data_ptrs[k];
+            } else {
+                // Take part in the collective write, without data.
+                H5Sselect_none(file_spaces[k]);
+                H5Sselect_none(mem_spaces[k]);
+                bufs[k] = &dummy;
             }
-
-            status = H5Sclose (memspace);
         }
 
-        ParallelDescriptor::Barrier();
+        // Create collective io prop list.
+        hid_t collective_plist = H5Pcreate(H5P_DATASET_XFER);
+        H5Pset_dxpl_mpio(collective_plist, H5FD_MPIO_COLLECTIVE);
+
+        herr_t status = output_write_multi(nfields, datasets.data(), mem_types.data(),
+                                           mem_spaces.data(), file_spaces.data(),
+                                           collective_plist, bufs.data());
+        if (status < 0)
+        {
+            amrex::Abort("Error on rank " + std::to_string(ParallelDescriptor::MyProc()) +
+                         " could not write particle data of " + species_name + ".\n");
+        }
 
         // Close resources.
         H5Pclose(collective_plist);
-        H5Sclose(filespace);
-        H5Dclose(dataset);
-        H5Fclose(file);
-        H5Pclose(pa_plist);
+        for (std::size_t k = 0; k < nfields; ++k) {
+            H5Sclose(mem_spaces[k]);
+            H5Sclose(file_spaces[k]);
+            H5Dclose(datasets[k]);
+        }
     }
 
     /*
       Creates an extendible dataset, suitable for storing particle data.
       Should be run on all ranks collectively.
     */
-    void output_create_particle_field(const std::string& file_path, const std::string& field_path)
+    void output_create_particle_field(hid_t file, const std::string& field_path)
     {
         BL_PROFILE("output_create_particle_field");
 
-        MPI_Comm comm = MPI_COMM_WORLD;
-        MPI_Info info = MPI_INFO_NULL;
-        int mpi_rank;
-        MPI_Comm_rank(comm, &mpi_rank);
-
-        // Create the file access prop list.
-        hid_t pa_plist = H5Pcreate(H5P_FILE_ACCESS);
-        H5Pset_fapl_mpio(pa_plist, comm, info);
-
-        // Open the output.
-        hid_t file = H5Fopen(file_path.c_str(), H5F_ACC_RDWR, pa_plist);
-
         constexpr int RANK = 1;
         hsize_t dims[1] = {0};
         hsize_t maxdims[1] = {H5S_UNLIMITED};
@@ -337,51 +344,40 @@ namespace
         H5Dclose(dataset);
         H5Pclose(prop);
         H5Sclose(dataspace);
-        H5Fclose(file);
     }
 
     /*
-      Write the only component in the multifab to the dataset given by field_name.
-      Uses hdf5-parallel.
+      Write all the components of the multifab to the datasets given by
+      field_paths (one per component), in the open file.
+      Uses hdf5-parallel, with collective writes: in each round, every rank
+      writes (at most) one of its boxes, for all the components at once.
+      With one box per rank, which is the usual case for the lab-frame
+      buffers, the whole buffer is thus written in a single collective operation.
+      Should be run on all ranks collectively.
     */
-    void output_write_field(const std::string& file_path,
-                            const std::string& field_path,
-                            const MultiFab& mf, const int comp,
-                            const int lo_x, const int lo_y, const int lo_z)
+    void output_write_fields(hid_t file, const std::vector<std::string>& field_paths,
+                             const MultiFab& mf,
+                             const int lo_x, const int lo_y, const int lo_z)
     {
-
-        BL_PROFILE("output_write_field");
-
-        MPI_Comm comm = MPI_COMM_WORLD;
-        MPI_Info info = MPI_INFO_NULL;
-        int mpi_rank;
-        MPI_Comm_rank(comm, &mpi_rank);
-
-        // Create the file access prop list.
-        hid_t pa_plist = H5Pcreate(H5P_FILE_ACCESS);
-        H5Pset_fapl_mpio(pa_plist, comm, info);
-
-        // Open the file, and the group.
-        hid_t file = H5Fopen(file_path.c_str(), H5F_ACC_RDWR, pa_plist);
-        // Open the field dataset.
-        hid_t dataset = H5Dopen(file, field_path.c_str(), H5P_DEFAULT);
-
-        // Make sure the dataset is there.
-        if (dataset < 0)
-        {
-            amrex::Abort("Error on rank " + std::to_string(mpi_rank) +
-                         ". Count not find dataset " + field_path + "\n");
+        BL_PROFILE("output_write_fields");
+
+        const int mpi_rank = ParallelDescriptor::MyProc();
+        const int ncomp = mf.nComp();
+        AMREX_ALWAYS_ASSERT(static_cast<int>(field_paths.size()) >= ncomp);
+
+        std::vector<hid_t> datasets(ncomp), file_spaces(ncomp), mem_spaces(ncomp);
+        std::vector<hid_t> mem_types(ncomp, H5T_NATIVE_DOUBLE);
+        std::vector<const void*> bufs(ncomp);
+        for (int comp = 0; comp < ncomp; ++comp) {
+            datasets[comp] = output_open_dataset(file, field_paths[comp]);
+            // Grab the dataspace of the field dataset from file.
+            file_spaces[comp] = H5Dget_space(datasets[comp]);
         }
 
-        // Grab the dataspace of the field dataset from file.
-        hid_t file_dataspace = H5Dget_space(dataset);
-
         // Create collective io prop list.
         hid_t collective_plist = H5Pcreate(H5P_DATASET_XFER);
-        H5Pset_dxpl_mpio(collective_plist, H5FD_MPIO_INDEPENDENT);
+        H5Pset_dxpl_mpio(collective_plist, H5FD_MPIO_COLLECTIVE);
 
-        // Iterate over Fabs, select matching hyperslab and write.
-        hid_t status;
         // slab lo index and shape.
 #if (AMREX_SPACEDIM == 3)
         hsize_t slab_offsets[3], slab_dims[3];
@@ -395,69 +391,93 @@ namespace
         shift[0] = lo_x;
         shift[1] = lo_z;
 #endif
-        hid_t slab_dataspace;
 
-        int write_count = 0;
+        // All the ranks must take part in the same number of collective writes.
+        const Vector<int>& local_boxes = mf.IndexArray();
+        int nrounds = local_boxes.size();
+        ParallelDescriptor::ReduceIntMax(nrounds);
 
+        // Data of all the components of one box, transposed to the file layout.
         std::vector<Real> transposed_data;
+        const double dummy = 0.;
 
-        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        for (int round = 0; round < nrounds; ++round)
         {
-            const Box& box = mfi.validbox();
-            const int *lo_vec = box.loVect();
-            const int *hi_vec = box.hiVect();
-
-            transposed_data.resize(box.numPts(), 0.0);
-
-            // Set slab offset and shape.
-            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+            if (round < static_cast<int>(local_boxes.size()))
             {
-                AMREX_ASSERT(lo_vec[idim] >= 0);
-                AMREX_ASSERT(hi_vec[idim] > lo_vec[idim]);
-                slab_offsets[idim] = lo_vec[idim] - shift[idim];
-                slab_dims[idim] = hi_vec[idim] - lo_vec[idim] + 1;
-            }
-
-            int cnt = 0;
-            AMREX_D_TERM(
-                         for (int i = lo_vec[0]; i <= hi_vec[0]; ++i),
-                         for (int j = lo_vec[1]; j <= hi_vec[1]; ++j),
-                         for (int k = lo_vec[2]; k <= hi_vec[2]; ++k))
-                transposed_data[cnt++] = mf[mfi](IntVect(AMREX_D_DECL(i, j, k)), comp);
-
-            // Create the slab space.
-            slab_dataspace = H5Screate_simple(AMREX_SPACEDIM, slab_dims, NULL);
+                const int ibox = local_boxes[round];
+                const Box& box = mf.boxArray()[ibox];
+                const int *lo_vec = box.loVect();
+                const int *hi_vec = box.hiVect();
+                const long npts = box.numPts();
+
+                transposed_data.resize(npts*ncomp, 0.0);
+
+                // Set slab offset and shape.
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+                {
+                    AMREX_ASSERT(lo_vec[idim] >= 0);
+                    AMREX_ASSERT(hi_vec[idim] > lo_vec[idim]);
+                    slab_offsets[idim] = lo_vec[idim] - shift[idim];
+                    slab_dims[idim] = hi_vec[idim] - lo_vec[idim] + 1;
+                }
 
-            // Select the hyperslab matching this fab.
-            status = H5Sselect_hyperslab(file_dataspace, H5S_SELECT_SET,
-                                         slab_offsets, NULL, slab_dims, NULL);
-            if (status < 0)
+                for (int comp = 0; comp < ncomp; ++comp)
+                {
+                    Real* comp_data = transposed_data.data() + comp*npts;
+                    int cnt = 0;
+                    AMREX_D_TERM(
+                                 for (int i = lo_vec[0]; i <= hi_vec[0]; ++i),
+                                 for (int j = lo_vec[1]; j <= hi_vec[1]; ++j),
+                                 for (int k = lo_vec[2]; k <= hi_vec[2]; ++k))
+                        comp_data[cnt++] = mf[ibox](IntVect(AMREX_D_DECL(i, j, k)), comp);
+
+                    // Create the slab space.
+                    mem_spaces[comp] = H5Screate_simple(AMREX_SPACEDIM, slab_dims, NULL);
+
+                    // Select the hyperslab matching this fab.
+                    herr_t status = H5Sselect_hyperslab(file_spaces[comp], H5S_SELECT_SET,
+                                                        slab_offsets, NULL, slab_dims, NULL);
+                    if (status < 0)
+                    {
+                        amrex::Abort("Error on rank " + std::to_string(mpi_rank) +
+                                     " could not select hyperslab.\n");
+                    }
+                    bufs[comp] = comp_data;
+                }
+            }
+            else
             {
-                amrex::Abort("Error on rank " + std::to_string(mpi_rank) +
-                             " could not select hyperslab.\n");
+                // No box left on this rank: take part in the collective write, without data.
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) slab_dims[idim] = 1;
+                for (int comp = 0; comp < ncomp; ++comp)
+                {
+                    mem_spaces[comp] = H5Screate_simple(AMREX_SPACEDIM, slab_dims, NULL);
+                    H5Sselect_none(mem_spaces[comp]);
+                    H5Sselect_none(file_spaces[comp]);
+                    bufs[comp] = &dummy;
+                }
             }
 
-            // Write this pencil.
-            status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, slab_dataspace,
-                              file_dataspace, collective_plist, transposed_data.data());
+            // Write all the components of this round.
+            herr_t status = output_write_multi(ncomp, datasets.data(), mem_types.data(),
+                                               mem_spaces.data(), file_spaces.data(),
+                                               collective_plist, bufs.data());
             if (status < 0)
             {
                 amrex::Abort("Error on rank " + std::to_string(mpi_rank) +
                              " could not write hyperslab.\n");
             }
 
-            H5Sclose(slab_dataspace);
-            write_count++;
+            for (int comp = 0; comp < ncomp; ++comp) H5Sclose(mem_spaces[comp]);
         }
 
-        ParallelDescriptor::Barrier();
-
         // Close HDF5 resources.
         H5Pclose(collective_plist);
-        H5Sclose(file_dataspace);
-        H5Dclose(dataset);
-        H5Fclose(file);
-        H5Pclose(pa_plist);
+        for (int comp = 0; comp < ncomp; ++comp) {
+            H5Sclose(file_spaces[comp]);
+            H5Dclose(datasets[comp]);
+        }
     }
 }
 #endif
@@ -518,6 +538,73 @@ LorentzTransformZ(MultiFab& data, Real gamma_boost, Real beta_boost, int ncomp)
         );
     }
 }
+
+/** \brief Cell-centered values of the fields (in the boosted frame) on the
+ * cell planes plane_lo to plane_hi along direction dir, averaged directly from
+ * the (staggered) simulation fields: the rest of the domain is not averaged.
+ * The returned MultiFab has one box per simulation box crossing the planes,
+ * owned by the same MPI rank.
+ */
+std::unique_ptr<MultiFab>
+GetCellCenteredPlanes (const Vector<const MultiFab*>& fields, const Geometry& geom,
+                       const int dir, const int plane_lo, const int plane_hi)
+{
+    const BoxArray cc_ba = amrex::convert(fields[0]->boxArray(), IntVect::TheZeroVector());
+    const DistributionMapping& dm = fields[0]->DistributionMap();
+
+    Box planes = geom.Domain();
+    planes.setSmall(dir, plane_lo);
+    planes.setBig(dir, plane_hi);
+    std::vector< std::pair<int,Box> > isects;
+    cc_ba.intersections(planes, isects);
+
+    BoxList bl;
+    Vector<int> pmap;
+    Vector<int> src_index;
+    for (const auto& isect : isects) {
+        bl.push_back(isect.second);
+        pmap.push_back(dm[isect.first]);
+        src_index.push_back(isect.first);
+    }
+    const int ncomp = fields.size();
+    auto cc = std::make_unique<MultiFab>(BoxArray(bl), DistributionMapping(std::move(pmap)),
+                                         ncomp, 0);
+    for (int comp = 0; comp < ncomp; ++comp) {
+        AverageAndCoarsenScalarField(*cc, *fields[comp], src_index, 1, 0, comp);
+    }
+    return cc;
+}
+
+/** \brief Linearly interpolate the cell planes plane_lo and plane_hi (along z)
+ * of `planes` into the single-cell slice `slice`, with weight `weight`
+ * for plane_hi. Both MultiFabs have the same transverse boxes.
+ */
+void
+InterpolateSlice (MultiFab& slice, const MultiFab& planes,
+                  const int plane_lo, const int plane_hi, const Real weight)
+{
+    const int ncomp = slice.nComp();
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(slice, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        const Box& tile_box = mfi.tilebox();
+        Array4<Real> const& dst = slice[mfi].array();
+        Array4<Real const> const& src = planes[mfi].array();
+        ParallelFor(tile_box, ncomp,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k, int n)
+            {
+#if (AMREX_SPACEDIM == 3)
+                dst(i, j, k, n) = (1._rt - weight)*src(i, j, plane_lo, n)
+                                + weight*src(i, j, plane_hi, n);
+#else
+                dst(i, j, k, n) = (1._rt - weight)*src(i, plane_lo, k, n)
+                                + weight*src(i, plane_hi, k, n);
+#endif
+            }
+        );
+    }
+}
 }
 
 BackTransformedDiagnostic::
@@ -721,12 +808,10 @@ void BackTransformedDiagnostic::Flush(const Geometry& geom)
                 tmp.copy(*m_LabFrameDiags_[i]->m_data_buffer_, 0, 0, ncomp);
 
 #ifdef WARPX_USE_HDF5
-                for (int comp = 0; comp < ncomp; ++comp) {
-                    output_write_field(m_LabFrameDiags_[i]->m_file_name,
-                                       m_mesh_field_names[comp], tmp, comp,
-                                       lbound(buff_box).x, lbound(buff_box).y,
-                                       lbound(buff_box).z);
-                }
+                output_write_fields(m_LabFrameDiags_[i]->m_h5_file,
+                                    m_mesh_field_names, tmp,
+                                    lbound(buff_box).x, lbound(buff_box).y,
+                                    lbound(buff_box).z);
 #else
                 std::stringstream ss;
                 ss << m_LabFrameDiags_[i]->m_file_name << "/Level_0/"
@@ -744,7 +829,7 @@ void BackTransformedDiagnostic::Flush(const Geometry& geom)
 #ifdef WARPX_USE_HDF5
                     // Dump species data
                     writeParticleDataHDF5(m_LabFrameDiags_[i]->m_particles_buffer_[j],
-                                          m_LabFrameDiags_[i]->m_file_name,
+                                          m_LabFrameDiags_[i]->m_h5_file,
                                           species_name);
 #else
                     std::stringstream part_ss;
@@ -757,6 +842,13 @@ void BackTransformedDiagnostic::Flush(const Geometry& geom)
                 }
                 m_LabFrameDiags_[i]->m_particles_buffer_.clear();
             }
+#ifdef WARPX_USE_HDF5
+            // The file stays open until the end of the run: flush it, so
+            // that the buffer just written can be read (or survives a crash)
+            if (m_LabFrameDiags_[i]->m_h5_file >= 0) {
+                H5Fflush(m_LabFrameDiags_[i]->m_h5_file, H5F_SCOPE_GLOBAL);
+            }
+#endif
             m_LabFrameDiags_[i]->m_buff_counter_ = 0;
         }
     }
@@ -770,7 +862,7 @@ void BackTransformedDiagnostic::Flush(const Geometry& geom)
 
 void
 BackTransformedDiagnostic::
-writeLabFrameData(const MultiFab* cell_centered_data,
+writeLabFrameData(const Vector<const MultiFab*>& fields,
                   const MultiParticleContainer& mypc,
                   const Geometry& geom, const Real t_boost, const Real dt) {
 
@@ -785,13 +877,18 @@ writeLabFrameData(const MultiFab* cell_centered_data,
     const std::vector<std::string> species_names = mypc.GetSpeciesNames();
     Real prev_t_lab = -dt;
     std::unique_ptr<amrex::MultiFab> tmp_slice_ptr;
-    std::unique_ptr<amrex::MultiFab> slice;
-    amrex::Vector<WarpXParticleContainer::DiagnosticParticleData> tmp_particle_buffer;
-
-    // Loop over snapshots
-    for (int i = 0; i < m_LabFrameDiags_.size(); ++i) {
-        // Get updated z position of snapshot
-        const Real old_z_boost = m_LabFrameDiags_[i]->m_current_z_boost;
+    // cell-centered fields on the planes bracketing z_boost, and interpolation weight
+    std::unique_ptr<amrex::MultiFab> planes;
+    int plane_lo = 0, plane_hi = 0;
+    Real plane_weight = 0.;
+
+    // Get updated z position of all the snapshots, and find those
+    // that intersect the simulation domain at this step
+    const int ndiags = m_LabFrameDiags_.size();
+    Vector<Real> old_z_boost(ndiags);
+    Vector<int> is_active(ndiags, 0);
+    for (int i = 0; i < ndiags; ++i) {
+        old_z_boost[i] = m_LabFrameDiags_[i]->m_current_z_boost;
         m_LabFrameDiags_[i]->updateCurrentZPositions(t_boost,
                                               m_inv_gamma_boost_,
                                               m_inv_beta_boost_);
@@ -803,6 +900,33 @@ writeLabFrameData(const MultiFab* cell_centered_data,
              ( m_LabFrameDiags_[i]->m_current_z_boost > zhi_boost) or
              ( m_LabFrameDiags_[i]->m_current_z_lab < diag_zmin_lab) or
              ( m_LabFrameDiags_[i]->m_current_z_lab > diag_zmax_lab) ) continue;
+        is_active[i] = 1;
+    }
+
+    // The back-transformed particles of all the active snapshots are obtained
+    // in a single pass over the particles. They are generated once per t_lab,
+    // and re-used if multiple diags have the same z_lab,t_lab.
+    // slice_index[i] is the index of the slice of snapshot i in particle_slices.
+    Vector<int> slice_index(ndiags, -1);
+    Vector<Vector<WarpXParticleContainer::DiagnosticParticleData> > particle_slices;
+    if (WarpX::do_back_transformed_particles) {
+        Vector<Real> slice_z_old, slice_z_new, slice_t_lab;
+        for (int i = 0; i < ndiags; ++i) {
+            if (!is_active[i]) continue;
+            if (slice_t_lab.empty() || m_LabFrameDiags_[i]->m_t_lab != slice_t_lab.back()) {
+                slice_z_old.push_back(old_z_boost[i]);
+                slice_z_new.push_back(m_LabFrameDiags_[i]->m_current_z_boost);
+                slice_t_lab.push_back(m_LabFrameDiags_[i]->m_t_lab);
+            }
+            slice_index[i] = slice_t_lab.size() - 1;
+        }
+        mypc.GetLabFrameData(m_boost_direction_, slice_z_old, slice_z_new,
+                             t_boost, slice_t_lab, dt, particle_slices);
+    }
+
+    // Loop over snapshots
+    for (int i = 0; i < ndiags; ++i) {
+        if (!is_active[i]) continue;
 
         // Get z index of data_buffer_ (i.e. in the lab frame) where
         // simulation domain (t', [zmin',zmax']), back-transformed to lab
@@ -830,26 +954,27 @@ writeLabFrameData(const MultiFab* cell_centered_data,
         }
 
         if (WarpX::do_back_transformed_fields) {
-            const int ncomp = cell_centered_data->nComp();
-            const int start_comp = 0;
-            const bool interpolate = true;
-            // slice containing back-transformed data is generated only if t_lab != prev_t_lab and is re-used if multiple diags have the same z_lab,t_lab.
+            const int ncomp = fields.size();
+            Real dx = geom.CellSize(m_boost_direction_);
+            // The cell-centered planes bracketing z_boost are generated only if
+            // t_lab != prev_t_lab and are re-used if multiple diags have the same z_lab,t_lab.
             if (m_LabFrameDiags_[i]->m_t_lab != prev_t_lab ) {
-               if (slice)
-               {
-                 slice.reset(new MultiFab);
-                 slice.reset(nullptr);
-               }
-               slice = amrex::get_slice_data(m_boost_direction_,
-                                             m_LabFrameDiags_[i]->m_current_z_boost,
-                                             *cell_centered_data, geom,
-                                             start_comp, ncomp,
-                                             interpolate);
-               // Back-transform data to the lab-frame
-               LorentzTransformZ(*slice, m_gamma_boost_, m_beta_boost_, ncomp);
+               // Position of z_boost, in number of cells from the center of cell 0
+               const Real z_cells = ( m_LabFrameDiags_[i]->m_current_z_boost -
+                                      geom.ProbLo(m_boost_direction_))/dx - 0.5;
+               const int dom_lo = geom.Domain().smallEnd(m_boost_direction_);
+               const int dom_hi = geom.Domain().bigEnd(m_boost_direction_);
+               plane_lo = static_cast<int>(std::floor(z_cells));
+               plane_hi = plane_lo + 1;
+               plane_weight = z_cells - plane_lo;
+               // At the edges of the domain, use the closest plane
+               if (plane_lo < dom_lo) plane_lo = dom_lo;
+               if (plane_hi > dom_hi) plane_hi = dom_hi;
+               if (plane_lo == plane_hi) plane_weight = 0.;
+               planes = GetCellCenteredPlanes(fields, geom, m_boost_direction_,
+                                              plane_lo, plane_hi);
              }
              // Create a 2D box for the slice in the boosted frame
-             Real dx = geom.CellSize(m_boost_direction_);
              int i_boost = ( m_LabFrameDiags_[i]->m_current_z_boost -
                              geom.ProbLo(m_boost_direction_))/dx;
              //Box slice_box = geom.Domain();
@@ -860,17 +985,29 @@ writeLabFrameData(const MultiFab* cell_centered_data,
              // Make it a BoxArray slice_ba
              BoxArray slice_ba(slice_box);
              slice_ba.maxSize(m_max_box_size_);
+             const DistributionMapping& buff_dm = m_LabFrameDiags_[i]->m_data_buffer_->DistributionMap();
              tmp_slice_ptr = std::unique_ptr<MultiFab>(new MultiFab(slice_ba,
-                             m_LabFrameDiags_[i]->m_data_buffer_->DistributionMap(),
-                             ncomp, 0));
-
-             // slice is re-used if the t_lab of a diag is equal to
-             // that of the previous diag.
-             // Back-transformed data is copied from slice
-             // which has the dmap of the domain to
-             // tmp_slice_ptr which has the dmap of the
-             // data_buffer that stores the back-transformed data.
-             tmp_slice_ptr->copy(*slice, 0, 0, ncomp);
+                             buff_dm, ncomp, 0));
+
+             // The planes are copied from `planes`, which has the dmap of the
+             // domain, to the same boxes as tmp_slice_ptr (extended to the
+             // planes), which have the dmap of the data_buffer that stores
+             // the back-transformed data.
+             BoxList planes_bl;
+             for (int ib = 0; ib < slice_ba.size(); ++ib) {
+                 Box b = slice_ba[ib];
+                 b.setSmall(m_boost_direction_, plane_lo);
+                 b.setBig(m_boost_direction_, plane_hi);
+                 planes_bl.push_back(b);
+             }
+             MultiFab tmp_planes(BoxArray(planes_bl), buff_dm, ncomp, 0);
+             tmp_planes.setVal(0.);
+             tmp_planes.ParallelCopy(*planes, 0, 0, ncomp);
+
+             // Interpolate to z_boost, and back-transform data to the lab-frame
+             InterpolateSlice(*tmp_slice_ptr, tmp_planes, plane_lo, plane_hi, plane_weight);
+             LorentzTransformZ(*tmp_slice_ptr, m_gamma_boost_, m_beta_boost_, ncomp);
+
              m_LabFrameDiags_[i]->AddDataToBuffer(*tmp_slice_ptr, i_lab,
                                                map_actual_fields_to_dump);
              tmp_slice_ptr.reset(new MultiFab);
@@ -878,21 +1015,7 @@ writeLabFrameData(const MultiFab* cell_centered_data,
         }
 
         if (WarpX::do_back_transformed_particles) {
-
-            if (m_LabFrameDiags_[i]->m_t_lab != prev_t_lab ) {
-               if (tmp_particle_buffer.size()>0)
-               {
-                  tmp_particle_buffer.clear();
-                  tmp_particle_buffer.shrink_to_fit();
-               }
-               tmp_particle_buffer.resize(mypc.nSpeciesBackTransformedDiagnostics());
-               mypc.GetLabFrameData(m_LabFrameDiags_[i]->m_file_name, i_lab,
-                                    m_boost_direction_, old_z_boost,
-                                    m_LabFrameDiags_[i]->m_current_z_boost,
-                                    t_boost, m_LabFrameDiags_[i]->m_t_lab, dt,
-                                    tmp_particle_buffer);
-            }
-            m_LabFrameDiags_[i]->AddPartDataToParticleBuffer(tmp_particle_buffer,
+            m_LabFrameDiags_[i]->AddPartDataToParticleBuffer(particle_slices[slice_index[i]],
                                mypc.nSpeciesBackTransformedDiagnostics());
         }
 
@@ -905,12 +1028,11 @@ writeLabFrameData(const MultiFab* cell_centered_data,
 #ifdef WARPX_USE_HDF5
 
                 Box buff_box = m_LabFrameDiags_[i]->m_buff_box_;
-                for (int comp = 0; comp < m_LabFrameDiags_[i]->m_data_buffer_->nComp(); ++comp)
-                    output_write_field(m_LabFrameDiags_[i]->m_file_name,
-                                       m_mesh_field_names[comp],
-                                       *m_LabFrameDiags_[i]->m_data_buffer_, comp,
-                                       lbound(buff_box).x, lbound(buff_box).y,
-                                       lbound(buff_box).z);
+                output_write_fields(m_LabFrameDiags_[i]->m_h5_file,
+                                    m_mesh_field_names,
+                                    *m_LabFrameDiags_[i]->m_data_buffer_,
+                                    lbound(buff_box).x, lbound(buff_box).y,
+                                    lbound(buff_box).z);
 #else
                 std::stringstream mesh_ss;
                 mesh_ss << m_LabFrameDiags_[i]->m_file_name << "/Level_0/" <<
@@ -928,7 +1050,7 @@ writeLabFrameData(const MultiFab* cell_centered_data,
 #ifdef WARPX_USE_HDF5
                     // Write data to disk (HDF5)
                     writeParticleDataHDF5(m_LabFrameDiags_[i]->m_particles_buffer_[j],
-                                          m_LabFrameDiags_[i]->m_file_name,
+                                          m_LabFrameDiags_[i]->m_h5_file,
                                           species_name);
 #else
                     std::stringstream part_ss;
@@ -943,6 +1065,13 @@ writeLabFrameData(const MultiFab* cell_centered_data,
                 }
                 m_LabFrameDiags_[i]->m_particles_buffer_.clear();
             }
+#ifdef WARPX_USE_HDF5
+            // The file stays open until the end of the run: flush it, so
+            // that the buffer just written can be read (or survives a crash)
+            if (m_LabFrameDiags_[i]->m_h5_file >= 0) {
+                H5Fflush(m_LabFrameDiags_[i]->m_h5_file, H5F_SCOPE_GLOBAL);
+            }
+#endif
             m_LabFrameDiags_[i]->m_buff_counter_ = 0;
         }
     }
@@ -954,7 +1083,7 @@ writeLabFrameData(const MultiFab* cell_centered_data,
 void
 BackTransformedDiagnostic::
 writeParticleDataHDF5(const WarpXParticleContainer::DiagnosticParticleData& pdata,
-                      const std::string& name, const std::string& species_name)
+                      hid_t file, const std::string& species_name)
 {
     auto np = pdata.GetRealData(DiagIdx::w).size();
 
@@ -972,30 +1101,16 @@ writeParticleDataHDF5(const WarpXParticleContainer::DiagnosticParticleData& pdat
 
     if (total_np == 0) return;
 
-    long old_np = 0;
-    if (ParallelDescriptor::IOProcessor())
-    {
-        for (int k = 0; k < static_cast<int>(particle_field_names.size()); ++k)
-        {
-            std::string field_path = species_name + "/" + particle_field_names[k];
-            old_np = output_resize_particle_field(name, field_path, total_np);
-        }
-    }
-
-    // Note, this has the effect of an MPI Barrier between the above resize operation
-    // and the below write.
-    ParallelDescriptor::ReduceLongMax(old_np);
-
-    // Write data here
+    // Extend the datasets and write all the fields in one collective operation
+    std::vector<const Real*> data_ptrs(particle_field_names.size());
     for (int k = 0; k < static_cast<int>(particle_field_names.size()); ++k)
     {
-        std::string field_path = species_name + "/" + particle_field_names[k];
-        output_write_particle_field(name, field_path,
-                                    pdata.GetRealData(k).data(),
-                                    particle_counts[ParallelDescriptor::MyProc()],
-                                    particle_offsets[ParallelDescriptor::MyProc()]
-                                    + old_np);
+        data_ptrs[k] = pdata.GetRealData(k).data();
     }
+    output_write_particle_fields(file, species_name, data_ptrs,
+                                 particle_counts[ParallelDescriptor::MyProc()],
+                                 particle_offsets[ParallelDescriptor::MyProc()],
+                                 total_np);
 }
 #endif
 
@@ -1140,6 +1255,14 @@ LabFrameSnapShot(Real t_lab_in, Real t_boost, Real inv_gamma_boost_in,
    if (WarpX::do_back_transformed_fields) m_data_buffer_.reset(nullptr);
 }
 
+LabFrameDiag::~LabFrameDiag()
+{
+#ifdef WARPX_USE_HDF5
+    // Collective: all the ranks hold the same diagnostics
+    if (m_h5_file >= 0) H5Fclose(m_h5_file);
+#endif
+}
+
 void
 LabFrameDiag::
 updateCurrentZPositions(Real t_boost, Real inv_gamma, Real inv_beta)
@@ -1179,6 +1302,10 @@ createLabFrameDirectories() {
 
     ParallelDescriptor::Barrier();
 
+    // The file stays open (with MPI-IO) until the diagnostic is destroyed,
+    // so that the buffer flushes do not re-open it.
+    m_h5_file = output_open(m_file_name);
+
     if (WarpX::do_back_transformed_particles){
         auto & mypc = WarpX::GetInstance().GetPartContainer();
         const std::vector<std::string> species_names = mypc.GetSpeciesNames();
@@ -1188,11 +1315,11 @@ createLabFrameDirectories() {
             // Loop over species to be dumped to BFD
             std::string species_name =
                 species_names[mypc.mapSpeciesBackTransformedDiagnostics(j)];
-            output_create_species_group(m_file_name, species_name);
+            output_create_species_group(m_h5_file, species_name);
             for (int k = 0; k < static_cast<int>(particle_field_names.size()); ++k)
             {
                 std::string field_path = species_name + "/" + particle_field_names[k];
-                output_create_particle_field(m_file_name, field_path);
+                output_create_particle_field(m_h5_file, field_path);
             }
         }
     }
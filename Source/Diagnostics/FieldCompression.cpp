@@ -0,0 +1,214 @@
+/* Copyright 2020
+ *
+ * This file is part of WarpX.
+ *
+ * License: BSD-3-Clause-LBNL
+ */
+#include "FieldCompression.H"
+
+#include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
+#include <AMReX_FArrayBox.H>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+using namespace amrex;
+
+namespace
+{
+    /** Append v to out as a variable-length integer (7 bits per byte) */
+    void
+    EncodeVarint (std::uint64_t v, std::vector<std::uint8_t>& out)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    /** \brief Quantize and encode the n values of data, with quantization
+     * step `step`, and append the result to out.
+     *
+     * Each value is predicted by the previously reconstructed value, and the
+     * residual is rounded to an integer number q of steps, so that the
+     * reconstructed value is within step/2 of the original one.
+     * The non-zero q are stored as zigzag-encoded variable-length integers,
+     * and each run of zeros as a 0 followed by the length of the run minus 1.
+     */
+    void
+    EncodeValues (const Real* data, const long n, const double step,
+                  std::vector<std::uint8_t>& out)
+    {
+        const double inv_step = 1./step;
+        double prediction = 0.;
+        long nzeros = 0;
+        for (long i = 0; i < n; ++i) {
+            const double residual = (static_cast<double>(data[i]) - prediction)*inv_step;
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(std::abs(residual) < 4.e18,
+                "Field compression: the tolerance is too small for the values of the field");
+            const std::int64_t q = std::llround(residual);
+            // Same operation as in the decoder, so that the predictions match
+            prediction += static_cast<double>(q)*step;
+            if (q == 0) {
+                ++nzeros;
+            } else {
+                if (nzeros > 0) {
+                    EncodeVarint(0, out);
+                    EncodeVarint(nzeros-1, out);
+                    nzeros = 0;
+                }
+                const std::uint64_t zigzag = (static_cast<std::uint64_t>(q) << 1)
+                                           ^ static_cast<std::uint64_t>(q >> 63);
+                EncodeVarint(zigzag, out);
+            }
+        }
+        if (nzeros > 0) {
+            EncodeVarint(0, out);
+            EncodeVarint(nzeros-1, out);
+        }
+    }
+}
+
+FieldCompression::FieldCompression ()
+{
+    ParmParse pp("compression");
+    Vector<std::string> fields;
+    pp.queryarr("fields", fields);
+    for (const auto& field : fields) {
+        ParmParse pp_field("compression." + field);
+        Tolerance tol;
+        tol.rel_tol = 1.e-3;
+        const bool has_abs_tol = pp_field.query("abs_tol", tol.abs_tol);
+        const bool has_rel_tol = pp_field.query("rel_tol", tol.rel_tol);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!(has_abs_tol && has_rel_tol),
+            "compression." + field + ": abs_tol and rel_tol cannot both be specified");
+        if (has_abs_tol) {
+            tol.rel_tol = 0.;
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(tol.abs_tol > 0.,
+                "compression." + field + ".abs_tol must be positive");
+        } else {
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(tol.rel_tol > 0.,
+                "compression." + field + ".rel_tol must be positive");
+        }
+        m_tolerances[field] = tol;
+    }
+}
+
+void
+FieldCompression::CheckFields (const Vector<std::string>& varnames) const
+{
+    for (const auto& tol : m_tolerances) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            std::find(varnames.begin(), varnames.end(), tol.first) != varnames.end(),
+            "compression.fields: " + tol.first + " is not a field of the plotfile "
+            "(see warpx.fields_to_plot)");
+    }
+}
+
+void
+FieldCompression::WriteCompressedFields (const std::string& dir,
+                                         const Vector<const MultiFab*>& mf,
+                                         const Vector<Geometry>& geom,
+                                         const Vector<std::string>& varnames,
+                                         const Real time) const
+{
+    BL_PROFILE("FieldCompression::WriteCompressedFields()");
+
+    const std::string cdir = dir + "/compressed_fields";
+    const int nlevels = mf.size();
+
+    // Components to compress
+    Vector<int> comps;
+    for (int comp = 0; comp < static_cast<int>(varnames.size()); ++comp) {
+        if (isCompressed(varnames[comp])) comps.push_back(comp);
+    }
+
+    // Quantization step of each field on each level (twice the tolerance)
+    Vector<Vector<double> > steps(nlevels);
+    for (int lev = 0; lev < nlevels; ++lev) {
+        for (const int comp : comps) {
+            const Tolerance& tol = m_tolerances.at(varnames[comp]);
+            // norm0 is a collective operation: all the ranks go through it
+            const Real field_max = mf[lev]->norm0(comp);
+            const Real abs_tol = (tol.abs_tol > 0.) ? tol.abs_tol : tol.rel_tol*field_max;
+            // A field that is 0 everywhere is encoded exactly, with any step
+            steps[lev].push_back( (abs_tol > 0.) ? 2.*abs_tol : 1. );
+        }
+    }
+
+    if (ParallelDescriptor::IOProcessor()) {
+        for (int lev = 0; lev < nlevels; ++lev) {
+            if (!UtilCreateDirectory(cdir + "/Level_" + std::to_string(lev), 0755)) {
+                CreateDirectoryFailed(cdir + "/Level_" + std::to_string(lev));
+            }
+        }
+        // Header: time, dimension, fields and, for each level,
+        // index domain, physical domain and quantization steps
+        std::ofstream header(cdir + "/Header");
+        header << std::setprecision(17);
+        header << "WarpX-compressed-fields-1\n";
+        header << time << "\n";
+        header << AMREX_SPACEDIM << "\n";
+        header << nlevels << "\n";
+        header << comps.size() << "\n";
+        for (const int comp : comps) header << varnames[comp] << " ";
+        header << "\n";
+        for (int lev = 0; lev < nlevels; ++lev) {
+            const Box& domain = geom[lev].Domain();
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) header << domain.smallEnd(idim) << " ";
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) header << domain.bigEnd(idim) << " ";
+            header << "\n";
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) header << geom[lev].ProbLo(idim) << " ";
+            header << "\n";
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) header << geom[lev].ProbHi(idim) << " ";
+            header << "\n";
+            for (const double step : steps[lev]) header << step << " ";
+            header << "\n";
+        }
+    }
+    ParallelDescriptor::Barrier();
+
+    // Data: one file per level and per rank, containing for each box its lower
+    // and upper corners, followed by the size and bytes of each encoded field
+    std::vector<std::uint8_t> buffer;
+    Gpu::streamSynchronize();
+    for (int lev = 0; lev < nlevels; ++lev) {
+        if (mf[lev]->local_size() == 0) continue;
+        const std::string filename = cdir + "/Level_" + std::to_string(lev)
+            + "/Data_" + Concatenate("", ParallelDescriptor::MyProc(), 5);
+        std::ofstream data(filename, std::ios::binary);
+        if (!data.good()) FileOpenFailed(filename);
+
+        for (MFIter mfi(*mf[lev]); mfi.isValid(); ++mfi) {
+            const Box& bx = mfi.validbox();
+            const long n = bx.numPts();
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                const std::int32_t lo = bx.smallEnd(idim);
+                data.write(reinterpret_cast<const char*>(&lo), sizeof(lo));
+            }
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                const std::int32_t hi = bx.bigEnd(idim);
+                data.write(reinterpret_cast<const char*>(&hi), sizeof(hi));
+            }
+
+            // The fields have no guard cells: each component of the fab holds
+            // the values on bx, in Fortran order, and is read in place (as in
+            // the openPMD output)
+            const FArrayBox& fab = (*mf[lev])[mfi];
+            AMREX_ALWAYS_ASSERT(fab.box() == bx);
+            for (int i = 0; i < static_cast<int>(comps.size()); ++i) {
+                buffer.clear();
+                EncodeValues(fab.dataPtr(comps[i]), n, steps[lev][i], buffer);
+                const std::uint64_t nbytes = buffer.size();
+                data.write(reinterpret_cast<const char*>(&nbytes), sizeof(nbytes));
+                data.write(reinterpret_cast<const char*>(buffer.data()), nbytes);
+            }
+        }
+    }
+}
@@ -418,6 +418,93 @@ AverageAndPackScalarFieldComponent (MultiFab& mf_avg,
     AverageAndPackScalarField(mf_avg, scalar_field_component, dcomp, ngrow);
 }
 
+namespace
+{
+    /** \brief Weight of the m-th point of the simulation grid (along one
+     * direction) when averaging a field to the center of a cell coarsened
+     * by r, where `nodal` is the staggering of the field along this direction
+     */
+    AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+    Real CoarsenWeight (const int m, const int r, const int nodal) noexcept
+    {
+        return (nodal && (m == 0 || m == r)) ? 0.5_rt/r : 1._rt/r;
+    }
+}
+
+/** \brief Takes the component `icomp` of the MultiFab `scalar_field` (with
+ * any staggering), averages it to the cell centers of the output grid and
+ * stores the result in mf_out (in the component dcomp).
+ * The output grid is the simulation grid restricted to the output region
+ * and coarsened by `crse_ratio` (see WarpX::GetFieldOutputLayout): box i of
+ * mf_out is contained in box src_index[i] of scalar_field.
+ * The averaging and the coarsening are done in one pass, so that no
+ * cell-centered field is allocated on the full simulation grid.
+ */
+void
+AverageAndCoarsenScalarField( MultiFab& mf_out,
+                              const MultiFab& scalar_field,
+                              const Vector<int>& src_index,
+                              const int crse_ratio,
+                              const int icomp, const int dcomp )
+{
+    const int r = crse_ratio;
+    const IntVect stag = scalar_field.ixType().toIntVect();
+#if (AMREX_SPACEDIM == 3)
+    const int sx = stag[0], sy = stag[1], sz = stag[2];
+#else
+    const int sx = stag[0], sz = stag[1];
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(mf_out, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.tilebox();
+        auto const& src = scalar_field[src_index[mfi.index()]].array();
+        auto const& dst = mf_out.array(mfi);
+
+        ParallelFor(bx,
+        [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real sum = 0._rt;
+#if (AMREX_SPACEDIM == 3)
+            for (int mz = 0; mz < r+sz; ++mz) {
+                for (int my = 0; my < r+sy; ++my) {
+                    for (int mx = 0; mx < r+sx; ++mx) {
+                        sum += CoarsenWeight(mx, r, sx)*CoarsenWeight(my, r, sy)
+                            *CoarsenWeight(mz, r, sz)*src(i*r+mx, j*r+my, k*r+mz, icomp);
+                    }
+                }
+            }
+#else
+            for (int mz = 0; mz < r+sz; ++mz) {
+                for (int mx = 0; mx < r+sx; ++mx) {
+                    sum += CoarsenWeight(mx, r, sx)*CoarsenWeight(mz, r, sz)
+                        *src(i*r+mx, j*r+mz, 0, icomp);
+                }
+            }
+#endif
+            dst(i, j, k, dcomp) = sum;
+        });
+    }
+}
+
+/** \brief Same as AverageAndCoarsenScalarField, for the 3 components of
+ * `vector_field`, stored in the components dcomp to dcomp+2 of mf_out.
+ */
+void
+AverageAndCoarsenVectorField( MultiFab& mf_out,
+                              const std::array< std::unique_ptr<MultiFab>, 3 >& vector_field,
+                              const Vector<int>& src_index,
+                              const int crse_ratio, const int dcomp )
+{
+    for (int i = 0; i < 3; ++i) {
+        AverageAndCoarsenScalarField(mf_out, *vector_field[i], src_index,
+                                     crse_ratio, 0, dcomp+i);
+    }
+}
+
 /** \brief Generate mode variable name
  */
 std::string
@@ -491,14 +578,99 @@ AddToVarNamesRZ (Vector<std::string>& varnames,
     for(auto coord:coords) varnames.push_back(name+coord+suffix);
 }
 
+/** \brief Layout of the field output on level `lev`: the part of the
+ * simulation grids inside the output region (warpx.plot_region_lo/hi,
+ * extended to a multiple of the coarsening ratio), coarsened by
+ * plot_coarsening_ratio. The output boxes keep the MPI rank of the
+ * simulation box they come from, so that no communication is needed.
+ * The BoxArray is empty if the output region is outside of the domain
+ * (e.g., once the moving window has left it).
+ */
+WarpX::FieldOutputLayout
+WarpX::GetFieldOutputLayout (const int lev) const
+{
+    const int r = plot_coarsening_ratio;
+
+    // Output region on level 0, in index space
+    const Geometry& gm0 = Geom(0);
+    Box region = gm0.Domain();
+    if (!plot_region_lo.empty()) {
+        IntVect lo, hi;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            lo[idim] = static_cast<int>(std::floor(
+                (plot_region_lo[idim] - gm0.ProbLo(idim))/gm0.CellSize(idim) ));
+            hi[idim] = static_cast<int>(std::ceil(
+                (plot_region_hi[idim] - gm0.ProbLo(idim))/gm0.CellSize(idim) )) - 1;
+        }
+        region &= Box(lo, hi);
+        if (!region.ok()) return FieldOutputLayout();
+        region.coarsen(r).refine(r);
+        region &= gm0.Domain();
+    }
+    // Same region on level lev
+    for (int l = 0; l < lev; ++l) region.refine(refRatio(l));
+
+    FieldOutputLayout layout;
+    BoxList bl;
+    Vector<int> pmap;
+    for (int i = 0; i < grids[lev].size(); ++i) {
+        const Box bx = grids[lev][i] & region;
+        if (bx.ok()) {
+            bl.push_back(amrex::coarsen(bx, r));
+            pmap.push_back(dmap[lev][i]);
+            layout.src_index.push_back(i);
+        }
+    }
+    layout.ba = BoxArray(bl);
+    layout.dm = DistributionMapping(std::move(pmap));
+
+    // Geometry of the output region
+    const Geometry& gm = Geom(lev);
+    RealBox rb;
+    Array<int,AMREX_SPACEDIM> is_periodic;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        rb.setLo(idim, gm.ProbLo(idim) + region.smallEnd(idim)*gm.CellSize(idim));
+        rb.setHi(idim, gm.ProbLo(idim) + (region.bigEnd(idim)+1)*gm.CellSize(idim));
+        is_periodic[idim] = (region.length(idim) == gm.Domain().length(idim)) ?
+            gm.isPeriodic(idim) : 0;
+    }
+    layout.geom.define(amrex::coarsen(region, r), &rb, gm.Coord(), is_periodic.data());
+
+    return layout;
+}
+
 /** \brief Write the different fields that are meant for output,
  * into the vector of MultiFab `mf_avg` (one MultiFab per level)
  * after averaging them to the cell centers.
+ * If `use_output_layout` is true, the fields are written on the output grid
+ * (restricted to the output region and coarsened, see GetFieldOutputLayout),
+ * and the levels that do not intersect the output region are skipped.
  */
 void
 WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
-                              amrex::Vector<MultiFab>& mf_avg, const int ngrow) const
+                              amrex::Vector<MultiFab>& mf_avg, const int ngrow,
+                              const bool use_output_layout) const
 {
+    AMREX_ALWAYS_ASSERT( !use_output_layout || ngrow == 0 );
+
+    if (use_output_layout && n_rz_azimuthal_modes > 1) {
+        // The azimuthal modes are combined on the full simulation grid,
+        // and then restricted/coarsened to the output grid
+        Vector<MultiFab> mf_full;
+        AverageAndPackFields( varnames, mf_full, 0 );
+        for (int lev = 0; lev <= finest_level; ++lev) {
+            const FieldOutputLayout layout = GetFieldOutputLayout(lev);
+            if (layout.ba.empty()) break;
+            const int ncomp = mf_full[lev].nComp();
+            mf_avg.push_back( MultiFab(layout.ba, layout.dm, ncomp, 0) );
+            for (int comp = 0; comp < ncomp; ++comp) {
+                AverageAndCoarsenScalarField( mf_avg[lev], mf_full[lev], layout.src_index,
+                                              plot_coarsening_ratio, comp, comp );
+            }
+        }
+        return;
+    }
+
     // Count how many different fields should be written (ncomp)
     int ncomp = fields_to_plot.size()
         + static_cast<int>(plot_finepatch)*6
@@ -525,8 +697,39 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
     // Loop over levels of refinement
     for (int lev = 0; lev <= finest_level; ++lev)
     {
+        // Grid on which the fields are written: either the simulation grid,
+        // or the (smaller) output grid, in which case the fields are averaged
+        // and coarsened in one pass
+        FieldOutputLayout layout;
+        if (use_output_layout) {
+            layout = GetFieldOutputLayout(lev);
+            if (layout.ba.empty()) break;
+        }
+        const bool full_grid = !use_output_layout ||
+            (plot_coarsening_ratio == 1 && layout.ba == grids[lev]);
+        const BoxArray& out_ba = full_grid ? grids[lev] : layout.ba;
+        const DistributionMapping& out_dm = full_grid ? dmap[lev] : layout.dm;
+
+        auto pack_vector = [&] (MultiFab& mf, const std::array< std::unique_ptr<MultiFab>, 3 >& vector_field,
+                                const int dcomp) {
+            if (full_grid) {
+                AverageAndPackVectorField( mf, vector_field, dmap[lev], dcomp, ngrow );
+            } else {
+                AverageAndCoarsenVectorField( mf, vector_field, layout.src_index,
+                                              plot_coarsening_ratio, dcomp );
+            }
+        };
+        auto pack_scalar = [&] (MultiFab& mf, const MultiFab& scalar_field, const int dcomp) {
+            if (full_grid) {
+                AverageAndPackScalarField( mf, scalar_field, dcomp, ngrow );
+            } else {
+                AverageAndCoarsenScalarField( mf, scalar_field, layout.src_index,
+                                              plot_coarsening_ratio, 0, dcomp );
+            }
+        };
+
         // Allocate pointers to the `ncomp` fields that will be added
-        mf_avg.push_back( MultiFab(grids[lev], dmap[lev], ncomp, ngrow));
+        mf_avg.push_back( MultiFab(out_ba, out_dm, ncomp, ngrow));
 
         // For E, B and J, if at least one component is requested,
         // build cell-centered temporary MultiFab with 3 comps
@@ -534,23 +737,23 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
         // Build mf_tmp_E is at least one component of E is requested
         if (is_in_vector(fields_to_plot, {"Ex", "Ey", "Ez"} )){
             // Allocate temp MultiFab with 3 components
-            mf_tmp_E = MultiFab(grids[lev], dmap[lev], nvecs, ngrow);
+            mf_tmp_E = MultiFab(out_ba, out_dm, nvecs, ngrow);
             // Fill MultiFab mf_tmp_E with averaged E
-            AverageAndPackVectorField(mf_tmp_E, Efield_aux[lev], dmap[lev], 0, ngrow);
+            pack_vector(mf_tmp_E, Efield_aux[lev], 0);
             int dcomp = 3;
             AverageAndPackVectorFieldComponents(mf_tmp_E, Efield_aux[lev], dmap[lev], dcomp, ngrow);
         }
         // Same for B
         if (is_in_vector(fields_to_plot, {"Bx", "By", "Bz"} )){
-            mf_tmp_B = MultiFab(grids[lev], dmap[lev], nvecs, ngrow);
-            AverageAndPackVectorField(mf_tmp_B, Bfield_aux[lev], dmap[lev], 0, ngrow);
+            mf_tmp_B = MultiFab(out_ba, out_dm, nvecs, ngrow);
+            pack_vector(mf_tmp_B, Bfield_aux[lev], 0);
             int dcomp = 3;
             AverageAndPackVectorFieldComponents(mf_tmp_B, Bfield_aux[lev], dmap[lev], dcomp, ngrow);
         }
         // Same for J
         if (is_in_vector(fields_to_plot, {"jx", "jy", "jz"} )){
-            mf_tmp_J = MultiFab(grids[lev], dmap[lev], nvecs, ngrow);
-            AverageAndPackVectorField(mf_tmp_J, current_fp[lev], dmap[lev], 0, ngrow);
+            mf_tmp_J = MultiFab(out_ba, out_dm, nvecs, ngrow);
+            pack_vector(mf_tmp_J, current_fp[lev], 0);
             int dcomp = 3;
             AverageAndPackVectorFieldComponents(mf_tmp_J, current_fp[lev], dmap[lev], dcomp, ngrow);
         }
@@ -592,19 +795,19 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
                 MultiFab::Copy( mf_avg[lev], mf_tmp_J, 2, dcomp++, 1, ngrow);
                 CopyVectorFieldComponentsToMultiFab(lev, mf_avg, mf_tmp_J, 2, dcomp, ngrow, "jz", varnames);
             } else if (fieldname == "rho"){
-                AverageAndPackScalarField( mf_avg[lev], *rho_fp[lev], dcomp++, ngrow );
+                pack_scalar( mf_avg[lev], *rho_fp[lev], dcomp++ );
                 CopyScalarFieldComponentsToMultiFab(lev, mf_avg, *rho_fp[lev], dcomp, ngrow, n_rz_azimuthal_modes,
                                                     fieldname, varnames);
             } else if (fieldname == "F"){
-                AverageAndPackScalarField( mf_avg[lev], *F_fp[lev], dcomp++, ngrow );
+                pack_scalar( mf_avg[lev], *F_fp[lev], dcomp++ );
                 CopyScalarFieldComponentsToMultiFab(lev, mf_avg, *F_fp[lev], dcomp, ngrow, n_rz_azimuthal_modes,
                                                     fieldname, varnames);
             } else if (fieldname == "part_per_cell") {
-                MultiFab temp_dat(grids[lev],mf_avg[lev].DistributionMap(),1,0);
+                MultiFab temp_dat(grids[lev],dmap[lev],1,0);
                 temp_dat.setVal(0);
                 // MultiFab containing number of particles in each cell
                 mypc->Increment(temp_dat, lev);
-                AverageAndPackScalarField( mf_avg[lev], temp_dat, dcomp++, ngrow );
+                pack_scalar( mf_avg[lev], temp_dat, dcomp++ );
             } else if (fieldname == "part_per_grid"){
                 const Vector<long>& npart_in_grid = mypc->NumberOfParticlesInGrid(lev);
                 // MultiFab containing number of particles per grid
@@ -613,7 +816,8 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
 #pragma omp parallel
 #endif
                 for (MFIter mfi(mf_avg[lev]); mfi.isValid(); ++mfi) {
-                    (mf_avg[lev])[mfi].setVal(static_cast<Real>(npart_in_grid[mfi.index()]));
+                    const int igrid = full_grid ? mfi.index() : layout.src_index[mfi.index()];
+                    (mf_avg[lev])[mfi].setVal(static_cast<Real>(npart_in_grid[igrid]));
                 }
                 dcomp++;
             } else if (fieldname == "part_per_proc"){
@@ -624,7 +828,7 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:n_per_proc)
 #endif
-                for (MFIter mfi(mf_avg[lev]); mfi.isValid(); ++mfi) {
+                for (MFIter mfi(grids[lev], dmap[lev]); mfi.isValid(); ++mfi) {
                     n_per_proc += npart_in_grid[mfi.index()];
                 }
                 mf_avg[lev].setVal(static_cast<Real>(n_per_proc),dcomp++,1);
@@ -636,11 +840,21 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
                 mf_avg[lev].setVal(static_cast<Real>(ParallelDescriptor::MyProc()),dcomp++,1);
             } else if (fieldname == "divB"){
                 if (do_nodal) amrex::Abort("TODO: do_nodal && plot divb");
-                ComputeDivB(mf_avg[lev], dcomp++,
-                            {Bfield_aux[lev][0].get(),
-                                    Bfield_aux[lev][1].get(),
-                                    Bfield_aux[lev][2].get()},
-                            WarpX::CellSize(lev) );
+                if (full_grid) {
+                    ComputeDivB(mf_avg[lev], dcomp++,
+                                {Bfield_aux[lev][0].get(),
+                                        Bfield_aux[lev][1].get(),
+                                        Bfield_aux[lev][2].get()},
+                                WarpX::CellSize(lev) );
+                } else {
+                    MultiFab divb(grids[lev],dmap[lev],1,0);
+                    ComputeDivB(divb, 0,
+                                {Bfield_aux[lev][0].get(),
+                                        Bfield_aux[lev][1].get(),
+                                        Bfield_aux[lev][2].get()},
+                                WarpX::CellSize(lev) );
+                    pack_scalar( mf_avg[lev], divb, dcomp++ );
+                }
             } else if (fieldname == "divE"){
                 if (do_nodal) amrex::Abort("TODO: do_nodal && plot dive");
                 const BoxArray& ba = amrex::convert(boxArray(lev),IntVect::TheUnitVector());
@@ -650,14 +864,14 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
                                      Efield_aux[lev][1].get(),
                                      Efield_aux[lev][2].get()},
                              WarpX::CellSize(lev) );
-                AverageAndPackScalarField( mf_avg[lev], dive, dcomp++, ngrow );
+                pack_scalar( mf_avg[lev], dive, dcomp++ );
             } else {
                 amrex::Abort("unknown field in fields_to_plot: " + fieldname);
             }
         }
         if (plot_finepatch)
         {
-            AverageAndPackVectorField( mf_avg[lev], Efield_fp[lev], dmap[lev], dcomp, ngrow );
+            pack_vector( mf_avg[lev], Efield_fp[lev], dcomp );
             dcomp += 3;
             AverageAndPackVectorFieldComponents(mf_avg[lev], Efield_fp[lev], dmap[lev], dcomp, ngrow);
             if (lev == 0) {
@@ -670,7 +884,7 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
                     }
                 }
             }
-            AverageAndPackVectorField( mf_avg[lev], Bfield_fp[lev], dmap[lev], dcomp, ngrow );
+            pack_vector( mf_avg[lev], Bfield_fp[lev], dcomp );
             dcomp += 3;
             AverageAndPackVectorFieldComponents(mf_avg[lev], Bfield_fp[lev], dmap[lev], dcomp, ngrow);
             if (lev == 0) {
@@ -695,7 +909,7 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
             {
                 if (do_nodal) amrex::Abort("TODO: do_nodal && plot_crsepatch");
                 std::array<std::unique_ptr<MultiFab>, 3> E = getInterpolatedE(lev);
-                AverageAndPackVectorField( mf_avg[lev], E, dmap[lev], dcomp, ngrow );
+                pack_vector( mf_avg[lev], E, dcomp );
 
             }
             if (lev == 0) AddToVarNames(varnames, "E", "_cp");
@@ -710,7 +924,7 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
             {
                 if (do_nodal) amrex::Abort("TODO: do_nodal && plot_crsepatch");
                 std::array<std::unique_ptr<MultiFab>, 3> B = getInterpolatedB(lev);
-                AverageAndPackVectorField( mf_avg[lev], B, dmap[lev], dcomp, ngrow );
+                pack_vector( mf_avg[lev], B, dcomp );
             }
             if (lev == 0) AddToVarNames(varnames, "B", "_cp");
             dcomp += 3;
@@ -718,7 +932,7 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
 
         if (costs[0] != nullptr and plot_costs)
         {
-            AverageAndPackScalarField( mf_avg[lev], *costs[lev], dcomp, ngrow );
+            pack_scalar( mf_avg[lev], *costs[lev], dcomp );
             if(lev==0) varnames.push_back("costs");
             dcomp += 1;
         }
@@ -728,34 +942,6 @@ WarpX::AverageAndPackFields ( Vector<std::string>& varnames,
 
 };
 
-/** \brief Reduce the size of all the fields in `source_mf`
-  * by `coarse_ratio` and store the results in `coarse_mf`.
-  * Calculate the corresponding coarse Geometry from `source_geom`
-  * and store the results in `coarse_geom` */
-void
-coarsenCellCenteredFields(
-    Vector<MultiFab>& coarse_mf, Vector<Geometry>& coarse_geom,
-    const Vector<MultiFab>& source_mf, const Vector<Geometry>& source_geom,
-    int coarse_ratio, int finest_level )
-{
-    // Check that the Vectors to be filled have an initial size of 0
-    AMREX_ALWAYS_ASSERT( coarse_mf.size()==0 );
-    AMREX_ALWAYS_ASSERT( coarse_geom.size()==0 );
-
-    // Fill the vectors with one element per level
-    int ncomp = source_mf[0].nComp();
-    for (int lev=0; lev<=finest_level; lev++) {
-        AMREX_ALWAYS_ASSERT( source_mf[lev].is_cell_centered() );
-
-        coarse_geom.push_back(amrex::coarsen( source_geom[lev], IntVect(coarse_ratio)));
-
-        BoxArray small_ba = amrex::coarsen(source_mf[lev].boxArray(), coarse_ratio);
-        coarse_mf.push_back( MultiFab(small_ba, source_mf[lev].DistributionMap(), ncomp, 0) );
-        average_down(source_mf[lev], coarse_mf[lev], 0, ncomp, IntVect(coarse_ratio));
-    }
-};
-
-
 /** \brief Write the data from MultiFab `F` into the file `filename`
  *  as a raw field (i.e. no interpolation to cell centers).
  *  Write guard cells if `plot_guards` is True.
@@ -8,9 +8,46 @@
  */
 #include <MultiParticleContainer.H>
 #include <WarpX.H>
+#include <ParticleOutputFilter.H>
+#include <FilterCopyTransform.H>
 
 using namespace amrex;
 
+/* Returns a copy of the particles selected for output (including runtime
+ * components), with momenta in SI units */
+std::unique_ptr<WarpXParticleContainer::OutputParticleContainer>
+WarpXParticleContainer::GetOutputParticles ()
+{
+    BL_PROFILE("WarpXParticleContainer::GetOutputParticles()");
+
+    auto pc_out = std::make_unique<OutputParticleContainer>(GetParGDB());
+    for (int comp = PIdx::nattribs; comp < NumRealComps(); ++comp) {
+        pc_out->AddRealComp(false);
+    }
+    for (int comp = 0; comp < NumIntComps(); ++comp) {
+        pc_out->AddIntComp(false);
+    }
+
+    // m_plot_filter_parser is in managed memory, so that it can be used on the device
+    auto filter = ParticleOutputFilterFunc{m_plot_filter_parser.get(), plot_random_fraction};
+    auto copy = ParticleOutputCopyFunc{
+        getMomentumConversionFactor(ConvertDirection::WarpX_to_SI)};
+
+    for (int lev = 0; lev <= finestLevel(); ++lev)
+    {
+        for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+        {
+            auto& src_tile = ParticlesAt(lev, pti);
+            auto& dst_tile = pc_out->DefineAndReturnParticleTile(
+                lev, pti.index(), pti.LocalTileIndex());
+            filterCopyTransformParticles<1>(dst_tile, src_tile, 0,
+                                            filter, copy, ParticleOutputTransformFunc{});
+        }
+    }
+
+    return pc_out;
+}
+
 void
 RigidInjectedParticleContainer::ReadHeader (std::istream& is)
 {
@@ -125,15 +162,25 @@ MultiParticleContainer::WritePlotFile (const std::string& dir) const
                 }
 #endif
 
-            // Convert momentum to SI
-            pc->ConvertUnits(ConvertDirection::WarpX_to_SI);
+            // The momenta need a conversion to SI units only if they are written
+            const bool convert_momenta =
+                (pc->plot_flags[PIdx::ux] || pc->plot_flags[PIdx::uy] || pc->plot_flags[PIdx::uz]) &&
+                pc->getMomentumConversionFactor(ConvertDirection::WarpX_to_SI) != 1.0;
+
             // real_names contains a list of all particle attributes.
             // pc->plot_flags is 1 or 0, whether quantity is dumped or not.
-            pc->WritePlotFile(dir, species_names[i],
-                              pc->plot_flags, int_flags,
-                              real_names, int_names);
-            // Convert momentum back to WarpX units
-            pc->ConvertUnits(ConvertDirection::SI_to_WarpX);
+            if (pc->hasOutputFilter() || convert_momenta) {
+                // Stage a copy of the selected particles with momentum in SI units,
+                // so that the particle data are not modified
+                auto pc_out = pc->GetOutputParticles();
+                pc_out->WritePlotFile(dir, species_names[i],
+                                      pc->plot_flags, int_flags,
+                                      real_names, int_names);
+            } else {
+                pc->WritePlotFile(dir, species_names[i],
+                                  pc->plot_flags, int_flags,
+                                  real_names, int_names);
+            }
         }
     }
 }
@@ -164,42 +211,16 @@ MultiParticleContainer::WriteHeader (std::ostream& os) const
 
 // Particle momentum is defined as gamma*velocity, which is neither
 // SI mass*gamma*velocity nor normalized gamma*velocity/c.
-// This converts momentum to SI units (or vice-versa) to write SI data
-// to file.
-void
-PhysicalParticleContainer::ConvertUnits(ConvertDirection convert_direction)
+// This returns the factor to convert momentum to SI units (or vice-versa)
+// to write SI data to file.
+ParticleReal
+PhysicalParticleContainer::getMomentumConversionFactor (ConvertDirection convert_direction) const
 {
-    BL_PROFILE("PPC::ConvertUnits()");
-
-    // Compute conversion factor
-    Real factor = 1;
+    ParticleReal factor = 1;
     if (convert_direction == ConvertDirection::WarpX_to_SI){
         factor = mass;
     } else if (convert_direction == ConvertDirection::SI_to_WarpX){
         factor = 1./mass;
     }
-
-    const int nLevels = finestLevel();
-    for (int lev=0; lev<=nLevels; lev++){
-#ifdef _OPENMP
-#pragma omp parallel if (Gpu::notInLaunchRegion())
-#endif
-        for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
-        {
-            // - momenta are stored as a struct of array, in `attribs`
-            auto& attribs = pti.GetAttribs();
-            ParticleReal* AMREX_RESTRICT ux = attribs[PIdx::ux].dataPtr();
-            ParticleReal* AMREX_RESTRICT uy = attribs[PIdx::uy].dataPtr();
-            ParticleReal* AMREX_RESTRICT uz = attribs[PIdx::uz].dataPtr();
-            // Loop over the particles and convert momentum
-            const long np = pti.numParticles();
-            ParallelFor( np,
-                [=] AMREX_GPU_DEVICE (long i) {
-                    ux[i] *= factor;
-                    uy[i] *= factor;
-                    uz[i] *= factor;
-                }
-            );
-        }
-    }
+    return factor;
 }
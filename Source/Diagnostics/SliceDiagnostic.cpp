@@ -16,57 +16,71 @@ using namespace amrex;
 
 
 /* \brief
- *  The functions creates the slice for diagnostics based on the user-input.
- *  The slice can be 1D, 2D, or 3D and it inherts the index type of the underlying data.
- *  The implementation assumes that the slice is aligned with the coordinate axes.
- *  The input parameters are modified if the user-input does not comply with requirements of coarsenability or if the slice extent is not contained within the simulation domain.
- *  First a slice multifab (smf) with cell size equal to that of the simulation grid is created such that it extends from slice.dim_lo to slice.dim_hi and shares the same index space as the source multifab (mf)
- *  The values are copied from src mf to dst smf using amrex::ParallelCopy
- *  If interpolation is required, then on the smf, using data points stored in the ghost cells, the data in interpolated.
- *  If coarsening is required, then a coarse slice multifab is generated (cs_mf) and the
- *  values of the refined slice (smf) is averaged down to obtain the coarse slice.
- *  \param mf is the source multifab containing the field data
- *  \param dom_geom is the geometry of the domain and used in the function to obtain the
- *  CellSize of the underlying grid.
- *  \param slice_realbox defines the extent of the slice
- *  \param slice_cr_ratio provides the coarsening ratio for diagnostics
+ *  Creates the slice of mf defined by slice_realbox and slice_cr_ratio,
+ *  without re-using any layout (see SliceGenerator::CreateSlice).
  */
-
 std::unique_ptr<MultiFab>
 CreateSlice( const MultiFab& mf, const Vector<Geometry> &dom_geom,
              RealBox &slice_realbox, IntVect &slice_cr_ratio )
 {
-    std::unique_ptr<MultiFab> smf;
-    std::unique_ptr<MultiFab> cs_mf;
-
-    Vector<int> slice_ncells(AMREX_SPACEDIM);
-    int nghost = 1;
-    int nlevels = dom_geom.size();
-    int ncomp = (mf).nComp();
+    SliceGenerator slice_generator;
+    return slice_generator.CreateSlice(mf, dom_geom, slice_realbox, slice_cr_ratio);
+}
 
-    AMREX_ALWAYS_ASSERT_WITH_MESSAGE( nlevels==1,
-       "Slice diagnostics does not work with mesh refinement yet (TO DO).");
 
-    const auto conversionType = (mf).ixType();
-    IntVect SliceType(AMREX_D_DECL(0,0,0));
-    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim )
+namespace
+{
+    bool SameRealBox (const RealBox& a, const RealBox& b)
     {
-        SliceType[idim] = conversionType.nodeCentered(idim);
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            if (a.lo(idim) != b.lo(idim) || a.hi(idim) != b.hi(idim)) return false;
+        }
+        return true;
     }
+}
+
 
+/* \brief
+ *  Returns the layout of the slice for data with index type SliceType. The layout
+ *  is computed (with CheckSliceInput) only if no layout was computed for the same
+ *  index type, slice parameters and domain, and is re-used otherwise.
+ *  slice_realbox and slice_cr_ratio are modified as in CheckSliceInput.
+ */
+const SliceGenerator::Layout&
+SliceGenerator::GetLayout( const IntVect& SliceType, const Vector<Geometry> &dom_geom,
+                           RealBox &slice_realbox, IntVect &slice_cr_ratio )
+{
     const RealBox& real_box = dom_geom[0].ProbDomain();
-    RealBox slice_cc_nd_box;
-    int slice_grid_size = 32;
+    const Box& domain = dom_geom[0].Domain();
+
+    for (const auto& layout : m_layouts) {
+        if ( layout->slice_type == SliceType &&
+             layout->input_cr_ratio == slice_cr_ratio &&
+             layout->domain == domain &&
+             SameRealBox(layout->input_realbox, slice_realbox) &&
+             SameRealBox(layout->real_box, real_box) )
+        {
+            slice_realbox = layout->slice_realbox;
+            slice_cr_ratio = layout->slice_cr_ratio;
+            return *layout;
+        }
+    }
+
+    std::unique_ptr<Layout> layout(new Layout);
+    layout->slice_type = SliceType;
+    layout->input_realbox = slice_realbox;
+    layout->input_cr_ratio = slice_cr_ratio;
+    layout->domain = domain;
+    layout->real_box = real_box;
 
-    bool interpolate = false;
-    bool coarsen = false;
+    int slice_grid_size = 32;
 
     // same index space as domain //
     IntVect slice_lo(AMREX_D_DECL(0,0,0));
     IntVect slice_hi(AMREX_D_DECL(1,1,1));
     IntVect interp_lo(AMREX_D_DECL(0,0,0));
 
-    CheckSliceInput(real_box, slice_cc_nd_box, slice_realbox, slice_cr_ratio,
+    CheckSliceInput(real_box, layout->slice_cc_nd_box, slice_realbox, slice_cr_ratio,
                     dom_geom, SliceType, slice_lo,
                     slice_hi, interp_lo);
     int configuration_dim = 0;
@@ -75,20 +89,14 @@ CreateSlice( const MultiFab& mf, const Vector<Geometry> &dom_geom,
 
        // Flag for interpolation if required //
        if ( interp_lo[idim] == 1) {
-          interpolate = 1;
+          layout->interpolate = true;
        }
 
        // For the case when a dimension is reduced //
-       if ( ( slice_hi[idim] - slice_lo[idim]) == 1) {
-          slice_ncells[idim] = 1;
-       }
-       else {
-          slice_ncells[idim] = ( slice_hi[idim] - slice_lo[idim] + 1 )
-                                / slice_cr_ratio[idim];
-
+       if ( ( slice_hi[idim] - slice_lo[idim]) != 1) {
           int refined_ncells = slice_hi[idim] - slice_lo[idim] + 1 ;
           if ( slice_cr_ratio[idim] > 1) {
-             coarsen = true;
+             layout->coarsen = true;
 
              // modify slice_grid_size if >= refines_cells //
              if ( slice_grid_size >= refined_ncells ) {
@@ -103,18 +111,94 @@ CreateSlice( const MultiFab& mf, const Vector<Geometry> &dom_geom,
        amrex::Warning("The slice configuration is 1D and cannot be visualized using yt.");
     }
 
+    layout->slice_realbox = slice_realbox;
+    layout->slice_cr_ratio = slice_cr_ratio;
+    layout->slice_lo = slice_lo;
+    layout->slice_hi = slice_hi;
+    layout->interp_lo = interp_lo;
+
     // Slice generation with index type inheritance //
     Box slice(slice_lo, slice_hi);
+    BoxArray sba(slice);
+    sba.maxSize(slice_grid_size);
+
+    // Re-use the BoxArray and DistributionMapping of an existing layout with
+    // the same boxes, e.g. for data with a different index type, so that
+    // AMReX re-uses the communication pattern of the ParallelCopy.
+    bool found = false;
+    for (const auto& other : m_layouts) {
+        if (other->ba == sba) {
+            layout->ba = other->ba;
+            layout->dm = other->dm;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        layout->ba = sba;
+        // Distribution mapping for slice can be different from that of domain //
+        layout->dm = DistributionMapping{sba};
+    }
+
+    if (layout->coarsen) {
+       layout->crse_ba = layout->ba;
+       layout->crse_ba.coarsen(slice_cr_ratio);
+       AMREX_ALWAYS_ASSERT(layout->crse_ba.size() == layout->ba.size());
+    }
+
+    // Keep the most recent layouts only, e.g. with a moving window
+    if (m_layouts.size() >= m_max_layouts) m_layouts.erase(m_layouts.begin());
+    m_layouts.push_back(std::move(layout));
+    return *m_layouts.back();
+}
+
+
+/* \brief
+ *  The functions creates the slice for diagnostics based on the user-input.
+ *  The slice can be 1D, 2D, or 3D and it inherts the index type of the underlying data.
+ *  The implementation assumes that the slice is aligned with the coordinate axes.
+ *  The input parameters are modified if the user-input does not comply with requirements of coarsenability or if the slice extent is not contained within the simulation domain.
+ *  First a slice multifab (smf) with cell size equal to that of the simulation grid is created such that it extends from slice.dim_lo to slice.dim_hi and shares the same index space as the source multifab (mf)
+ *  The values are copied from src mf to dst smf using amrex::ParallelCopy
+ *  If interpolation is required, then on the smf, using data points stored in the ghost cells, the data in interpolated.
+ *  If coarsening is required, then a coarse slice multifab is generated (cs_mf) and the
+ *  values of the refined slice (smf) is averaged down to obtain the coarse slice.
+ *  The layout of the slice (see GetLayout) is re-used between calls.
+ *  \param mf is the source multifab containing the field data
+ *  \param dom_geom is the geometry of the domain and used in the function to obtain the
+ *  CellSize of the underlying grid.
+ *  \param slice_realbox defines the extent of the slice
+ *  \param slice_cr_ratio provides the coarsening ratio for diagnostics
+ */
 
-    Vector<BoxArray> sba(1);
-    sba[0].define(slice);
-    sba[0].maxSize(slice_grid_size);
+std::unique_ptr<MultiFab>
+SliceGenerator::CreateSlice( const MultiFab& mf, const Vector<Geometry> &dom_geom,
+                             RealBox &slice_realbox, IntVect &slice_cr_ratio )
+{
+    BL_PROFILE("SliceGenerator::CreateSlice()");
+
+    std::unique_ptr<MultiFab> smf;
+    std::unique_ptr<MultiFab> cs_mf;
+
+    int nghost = 1;
+    int nlevels = dom_geom.size();
+    int ncomp = (mf).nComp();
 
-    // Distribution mapping for slice can be different from that of domain //
-    Vector<DistributionMapping> sdmap(1);
-    sdmap[0] = DistributionMapping{sba[0]};
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE( nlevels==1,
+       "Slice diagnostics does not work with mesh refinement yet (TO DO).");
 
-    smf.reset(new MultiFab(amrex::convert(sba[0],SliceType), sdmap[0],
+    const auto conversionType = (mf).ixType();
+    IntVect SliceType(AMREX_D_DECL(0,0,0));
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim )
+    {
+        SliceType[idim] = conversionType.nodeCentered(idim);
+    }
+
+    const RealBox& real_box = dom_geom[0].ProbDomain();
+
+    const Layout& layout = GetLayout(SliceType, dom_geom, slice_realbox, slice_cr_ratio);
+
+    smf.reset(new MultiFab(amrex::convert(layout.ba,SliceType), layout.dm,
                            ncomp, nghost));
 
     // Copy data from domain to slice that has same cell size as that of //
@@ -122,24 +206,19 @@ CreateSlice( const MultiFab& mf, const Vector<Geometry> &dom_geom,
     smf->ParallelCopy(mf, 0, 0, ncomp,nghost,nghost);
 
     // inteprolate if required on refined slice //
-    if (interpolate == 1 ) {
-       InterpolateSliceValues( *smf, interp_lo, slice_cc_nd_box, dom_geom,
-                               ncomp, nghost, slice_lo, slice_hi, SliceType, real_box);
+    if (layout.interpolate) {
+       InterpolateSliceValues( *smf, layout.interp_lo, layout.slice_cc_nd_box, dom_geom,
+                               ncomp, nghost, layout.slice_lo, layout.slice_hi,
+                               SliceType, real_box);
     }
 
 
-    if (coarsen == false) {
+    if (layout.coarsen == false) {
        return smf;
     }
-    else if ( coarsen == true ) {
-       Vector<BoxArray> crse_ba(1);
-       crse_ba[0] = sba[0];
-       crse_ba[0].coarsen(slice_cr_ratio);
-
-       AMREX_ALWAYS_ASSERT(crse_ba[0].size() == sba[0].size());
-
-       cs_mf.reset( new MultiFab(amrex::convert(crse_ba[0],SliceType),
-                    sdmap[0], ncomp,nghost));
+    else if ( layout.coarsen == true ) {
+       cs_mf.reset( new MultiFab(amrex::convert(layout.crse_ba,SliceType),
+                    layout.dm, ncomp,nghost));
 
        MultiFab& mfSrc = *smf;
        MultiFab& mfDst = *cs_mf;
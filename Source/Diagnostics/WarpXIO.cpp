@@ -9,10 +9,12 @@
  */
 #include <AMReX_MultiFabUtil.H>
 #include <AMReX_PlotFileUtil.H>
+#include <AMReX_Utility.H>
 #include <AMReX_FillPatchUtil_F.H>
 
 #include <WarpX.H>
 #include <FieldIO.H>
+#include <FieldCompression.H>
 
 #include "AMReX_buildInfo.H"
 
@@ -515,19 +517,21 @@ WarpX::prepareFields(
         Vector<const MultiFab*>& output_mf,
         Vector<Geometry>& output_geom
 ) const {
-    // Average the fields from the simulation grid to the cell centers
+    // Average the fields from the simulation grid to the cell centers of
+    // the output grid, i.e. only inside the output region and directly
+    // coarsened, if requested by the user
     const int ngrow = 0;
-    WarpX::AverageAndPackFields( varnames, mf_avg, ngrow );
+    WarpX::AverageAndPackFields( varnames, mf_avg, ngrow, true );
 
-    // Coarsen the fields, if requested by the user
-    Vector<MultiFab> coarse_mf; // will remain empty if there is no coarsening
-    if (plot_coarsening_ratio != 1) {
-        coarsenCellCenteredFields( coarse_mf, output_geom, mf_avg, Geom(),
-                                   plot_coarsening_ratio, finest_level );
-        output_mf = amrex::GetVecOfConstPtrs(coarse_mf);
-    } else {  // No averaging necessary, simply point to mf_avg
-        output_mf = amrex::GetVecOfConstPtrs(mf_avg);
-        output_geom = Geom();
+    output_mf = amrex::GetVecOfConstPtrs(mf_avg);
+    output_geom.clear();
+    for (int lev = 0; lev < static_cast<int>(mf_avg.size()); ++lev) {
+        output_geom.push_back( GetFieldOutputLayout(lev).geom );
+    }
+    if (mf_avg.empty()) {
+        amrex::Warning("The field output region (warpx.plot_region_lo/hi) does not "
+                       "intersect the simulation domain: the fields are not written "
+                       "at step " + std::to_string(step));
     }
 }
 
@@ -547,11 +551,15 @@ WarpX::WriteOpenPMDFile () const
     prepareFields(step, varnames, mf_avg, output_mf, output_geom);
 
     m_OpenPMDPlotWriter->SetStep(step);
-    // fields: only dumped for coarse level
-    m_OpenPMDPlotWriter->WriteOpenPMDFields(
-        varnames, *output_mf[0], output_geom[0], step, t_new[0]);
+    // fields: only dumped for coarse level (if it intersects the output region)
+    if (!output_mf.empty()) {
+        m_OpenPMDPlotWriter->WriteOpenPMDFields(
+            varnames, *output_mf[0], output_geom[0], step, t_new[0]);
+    }
     // particles: all (reside only on locally finest level)
     m_OpenPMDPlotWriter->WriteOpenPMDParticles(mypc);
+    // write to disk (in the background if warpx.openpmd_async=1)
+    m_OpenPMDPlotWriter->Flush();
 #endif
 }
 
@@ -571,21 +579,60 @@ WarpX::WritePlotFile () const
 
     prepareFields(step, varnames, mf_avg, output_mf, output_geom);
 
-    // Write the fields contained in `mf_avg`, and corresponding to the
-    // names `varnames`, into a plotfile.
+    // The fields listed in compression.fields are written separately,
+    // with lossy compression: only copy the other ones for the plotfile
+    const FieldCompression& compression = *m_field_compression;
+    Vector<std::string> plot_varnames = varnames;
+    Vector<const MultiFab*> plot_mf = output_mf;
+    Vector<MultiFab> uncompressed_mf;
+    if (compression.isActive() && !output_mf.empty()) {
+        compression.CheckFields(varnames);
+        Vector<int> plot_comps;
+        plot_varnames.clear();
+        for (int comp = 0; comp < static_cast<int>(varnames.size()); ++comp) {
+            if (!compression.isCompressed(varnames[comp])) {
+                plot_comps.push_back(comp);
+                plot_varnames.push_back(varnames[comp]);
+            }
+        }
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!plot_comps.empty(),
+            "At least one field of warpx.fields_to_plot should not be in compression.fields");
+        for (int lev = 0; lev < static_cast<int>(output_mf.size()); ++lev) {
+            uncompressed_mf.push_back( MultiFab(output_mf[lev]->boxArray(),
+                output_mf[lev]->DistributionMap(), plot_comps.size(), 0) );
+            for (int i = 0; i < static_cast<int>(plot_comps.size()); ++i) {
+                MultiFab::Copy(uncompressed_mf[lev], *output_mf[lev], plot_comps[i], i, 1, 0);
+            }
+        }
+        plot_mf = amrex::GetVecOfConstPtrs(uncompressed_mf);
+    }
+
+    // Write the fields contained in `plot_mf`, and corresponding to the
+    // names `plot_varnames`, into a plotfile.
     // Prepare extra directory (filled later), for the raw fields
     Vector<std::string> rfs;
     VisMF::Header::Version current_version = VisMF::GetHeaderVersion();
     VisMF::SetHeaderVersion(plotfile_headerversion);
     if (plot_raw_fields) rfs.emplace_back("raw_fields");
-    amrex::WriteMultiLevelPlotfile(plotfilename, finest_level+1,
-                                   output_mf, varnames, output_geom,
-                                   t_new[0], istep, refRatio(),
-                                   "HyperCLaw-V1.1",
-                                   "Level_",
-                                   "Cell",
-                                   rfs
-                                   );
+    // (the levels that do not intersect the output region are not written;
+    // if none does, only the directory is created, for the other data)
+    if (plot_mf.empty()) {
+        amrex::UtilCreateCleanDirectory(plotfilename);
+    } else {
+        amrex::WriteMultiLevelPlotfile(plotfilename, plot_mf.size(),
+                                       plot_mf, plot_varnames, output_geom,
+                                       t_new[0], istep, refRatio(),
+                                       "HyperCLaw-V1.1",
+                                       "Level_",
+                                       "Cell",
+                                       rfs
+                                       );
+    }
+
+    if (compression.isActive() && !output_mf.empty()) {
+        compression.WriteCompressedFields(plotfilename, output_mf, output_geom,
+                                          varnames, t_new[0]);
+    }
 
 
     if (plot_raw_fields)
@@ -874,21 +921,25 @@ WarpX::SliceGenerationForDiagnostics ()
     Vector<Geometry> dom_geom;
     dom_geom = Geom();
 
+    // The layouts of the slices are kept across slice outputs
+    if (!m_slice_generator) m_slice_generator = std::make_unique<SliceGenerator>();
+    SliceGenerator& slice_generator = *m_slice_generator;
+
     if (F_fp[0] ) {
-       F_slice[0] = CreateSlice( *F_fp[0].get(), dom_geom, slice_realbox,
-                                 slice_cr_ratio );
+       F_slice[0] = slice_generator.CreateSlice( *F_fp[0].get(), dom_geom, slice_realbox,
+                                                 slice_cr_ratio );
     }
     if (rho_fp[0]) {
-       rho_slice[0] = CreateSlice( *rho_fp[0].get(), dom_geom, slice_realbox,
-                                   slice_cr_ratio );
+       rho_slice[0] = slice_generator.CreateSlice( *rho_fp[0].get(), dom_geom, slice_realbox,
+                                                   slice_cr_ratio );
     }
 
     for (int idim = 0; idim < 3; ++idim) {
-       Efield_slice[0][idim] = CreateSlice( *Efield_fp[0][idim].get(),
+       Efield_slice[0][idim] = slice_generator.CreateSlice( *Efield_fp[0][idim].get(),
                                 dom_geom, slice_realbox, slice_cr_ratio );
-       Bfield_slice[0][idim] = CreateSlice( *Bfield_fp[0][idim].get(),
+       Bfield_slice[0][idim] = slice_generator.CreateSlice( *Bfield_fp[0][idim].get(),
                                dom_geom, slice_realbox, slice_cr_ratio );
-       current_slice[0][idim] = CreateSlice( *current_fp[0][idim].get(),
+       current_slice[0][idim] = slice_generator.CreateSlice( *current_fp[0][idim].get(),
                                dom_geom, slice_realbox, slice_cr_ratio );
     }
 
@@ -90,11 +90,42 @@ namespace detail
     }
 }
 
+WarpXOpenPMDStagingPool::WarpXOpenPMDStagingPool()
+  : m_State(std::make_shared<State>())
+{}
+
+std::shared_ptr< char >
+WarpXOpenPMDStagingPool::acquire(std::size_t bytes)
+{
+  std::unique_ptr< char[] > buf;
+  std::size_t size = bytes;
+  {
+    // reuse the smallest free buffer that is large enough (but not too large)
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    auto it = m_State->free_buffers.lower_bound(bytes);
+    if( it != m_State->free_buffers.end() && it->first <= 2u*bytes + 4096u ) {
+      size = it->first;
+      buf = std::move(it->second);
+      m_State->free_buffers.erase(it);
+    }
+  }
+  if( !buf )
+    buf.reset(new char[size]);
+
+  std::shared_ptr< State > state = m_State;
+  return std::shared_ptr< char >(buf.release(), [state, size](char* p){
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->free_buffers.emplace(size, std::unique_ptr< char[] >(p));
+  });
+}
+
 WarpXOpenPMDPlot::WarpXOpenPMDPlot(bool oneFilePerTS,
-    std::string openPMDFileType, std::vector<bool> fieldPMLdirections)
+    std::string openPMDFileType, std::vector<bool> fieldPMLdirections,
+    bool async)
   :m_Series(nullptr),
    m_OneFilePerTS(oneFilePerTS),
    m_OpenPMDFileType(std::move(openPMDFileType)),
+   m_Async(async),
    m_fieldPMLdirections(std::move(fieldPMLdirections))
 {
   // pick first available backend if default is chosen
@@ -108,10 +139,27 @@ WarpXOpenPMDPlot::WarpXOpenPMDPlot(bool oneFilePerTS,
 #else
     m_OpenPMDFileType = "json";
 #endif
+
+#ifdef AMREX_USE_MPI
+  // the background thread flushes with collective MPI-I/O calls,
+  // concurrently with the communications of the simulation
+  if( m_Async && amrex::ParallelDescriptor::NProcs() > 1 )
+  {
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    if( provided < MPI_THREAD_MULTIPLE )
+    {
+      amrex::Print() << "Warning: MPI was not initialized with MPI_THREAD_MULTIPLE, "
+                     << "openPMD data will be flushed synchronously.\n";
+      m_Async = false;
+    }
+  }
+#endif
 }
 
 WarpXOpenPMDPlot::~WarpXOpenPMDPlot()
 {
+  WaitForPendingFlush();
   if( m_Series )
   {
     m_Series->flush();
@@ -119,6 +167,44 @@ WarpXOpenPMDPlot::~WarpXOpenPMDPlot()
   }
 }
 
+void
+WarpXOpenPMDPlot::WaitForPendingFlush() const
+{
+  if( m_PendingFlush.valid() )
+  {
+    BL_PROFILE("WarpXOpenPMDPlot::WaitForPendingFlush()");
+    m_PendingFlush.get();
+    m_PendingParticles.clear();
+  }
+}
+
+void
+WarpXOpenPMDPlot::FlushIfSync() const
+{
+  if( !m_Async )
+    m_Series->flush();
+}
+
+void
+WarpXOpenPMDPlot::Flush()
+{
+  BL_PROFILE("WarpXOpenPMDPlot::Flush()");
+  AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_Series != nullptr, "openPMD series must be initialized");
+
+  WaitForPendingFlush();
+  if( m_Async )
+  {
+    // all data are staged: the series is only accessed by the background
+    // thread until the next call to WaitForPendingFlush()
+    openPMD::Series* series = m_Series.get();
+    m_PendingFlush = std::async(std::launch::async, [series](){ series->flush(); });
+  }
+  else
+  {
+    m_Series->flush();
+  }
+}
+
 
 //
 //
@@ -158,6 +244,7 @@ WarpXOpenPMDPlot::Init(openPMD::AccessType accessType)
 
     // close a previously open series before creating a new one
     // see ADIOS1 limitation: https://github.com/openPMD/openPMD-api/pull/686
+    WaitForPendingFlush();
     m_Series = nullptr;
 
     if( amrex::ParallelDescriptor::NProcs() > 1 )
@@ -238,8 +325,6 @@ WarpXOpenPMDPlot::WriteOpenPMDParticles(const std::unique_ptr<MultiParticleConta
          int_flags.resize(1, 1);
       }
 
-      // Convert momentum to SI
-      pc->ConvertUnits(ConvertDirection::WarpX_to_SI);
       // real_names contains a list of all real particle attributes.
       // pc->plot_flags is 1 or 0, whether quantity is dumped or not.
 
@@ -253,9 +338,6 @@ WarpXOpenPMDPlot::WriteOpenPMDParticles(const std::unique_ptr<MultiParticleConta
            int_flags,
            real_names, int_names);
       }
-
-      // Convert momentum back to WarpX units
-      pc->ConvertUnits(ConvertDirection::SI_to_WarpX);
     }
   }
 }
@@ -272,8 +354,26 @@ WarpXOpenPMDPlot::SavePlotFile (const std::unique_ptr<WarpXParticleContainer>& p
                     const amrex::Vector<std::string>&  int_comp_names) const
 {
   AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_Series != nullptr, "openPMD series must be initialized");
-
-  WarpXParticleCounter counter(pc);
+  WaitForPendingFlush();
+
+  // If only a subset of the particles is written, they are copied to a
+  // separate container, with momenta in SI units. Otherwise, the particles are
+  // written from the species itself, and the momenta are converted to SI units
+  // in the staging buffers.
+  std::unique_ptr<WarpXParticleContainer::OutputParticleContainer> pc_filtered;
+  amrex::ParticleReal momentum_factor = pc->getMomentumConversionFactor(ConvertDirection::WarpX_to_SI);
+  if (pc->hasOutputFilter()) {
+      pc_filtered = pc->GetOutputParticles();
+      momentum_factor = 1.0;
+  }
+  WarpXParticleContainer::OutputParticleContainer& pc_out =
+      pc_filtered ? *pc_filtered : *pc;
+  // The SoA data can be passed to openPMD without copy unless they may be
+  // modified before they are flushed, i.e. in asynchronous mode when
+  // writing from the species itself. (In asynchronous mode, the filtered
+  // copy is kept until the background flush completes.)
+  bool const share_soa = !m_Async || pc_filtered != nullptr;
+  WarpXParticleCounter counter(pc_out);
 
   openPMD::Iteration currIteration = m_Series->iterations[iteration];
   openPMD::ParticleSpecies currSpecies = currIteration.particles[name];
@@ -319,13 +419,14 @@ WarpXOpenPMDPlot::SavePlotFile (const std::unique_ptr<WarpXParticleContainer>& p
   SetupRealProperties(currSpecies, write_real_comp, real_comp_names, counter.GetTotalNumParticles());
 
   // open files from all processors, in case some will not contribute below
-  m_Series->flush();
+  // (in asynchronous mode, all processors take part in the final flush)
+  FlushIfSync();
 
-  for (auto currentLevel = 0; currentLevel <= pc->finestLevel(); currentLevel++)
+  for (auto currentLevel = 0; currentLevel <= pc_out.finestLevel(); currentLevel++)
     {
       uint64_t offset = static_cast<uint64_t>( counter.m_ParticleOffsetAtRank[currentLevel] );
 
-      for (WarpXParIter pti(*pc, currentLevel); pti.isValid(); ++pti) {
+      for (WarpXParIter pti(pc_out, currentLevel); pti.isValid(); ++pti) {
          auto const numParticleOnTile = pti.numParticles();
          uint64_t const numParticleOnTile64 = static_cast<uint64_t>( numParticleOnTile );
 
@@ -337,10 +438,7 @@ WarpXOpenPMDPlot::SavePlotFile (const std::unique_ptr<WarpXParticleContainer>& p
            // Save positions
            std::vector<std::string> axisNames={"x", "y", "z"};
            for (auto currDim = 0; currDim < AMREX_SPACEDIM; currDim++) {
-                std::shared_ptr< amrex::ParticleReal > curr(
-                    new amrex::ParticleReal[numParticleOnTile],
-                    [](amrex::ParticleReal const *p){ delete[] p; }
-                );
+                auto curr = m_StagingPool.get< amrex::ParticleReal >(numParticleOnTile);
                 for (auto i=0; i<numParticleOnTile; i++) {
                      curr.get()[i] = aos[i].m_rdata.pos[currDim];
                 }
@@ -348,10 +446,7 @@ WarpXOpenPMDPlot::SavePlotFile (const std::unique_ptr<WarpXParticleContainer>& p
            }
 
            // save particle ID after converting it to a globally unique ID
-           std::shared_ptr< uint64_t > ids(
-               new uint64_t[numParticleOnTile],
-               [](uint64_t const *p){ delete[] p; }
-           );
+           auto ids = m_StagingPool.get< uint64_t >(numParticleOnTile);
            for (auto i=0; i<numParticleOnTile; i++) {
                detail::GlobalID const nextID = { aos[i].m_idata.id, aos[i].m_idata.cpu };
                ids.get()[i] = nextID.global_id;
@@ -363,12 +458,14 @@ WarpXOpenPMDPlot::SavePlotFile (const std::unique_ptr<WarpXParticleContainer>& p
          SaveRealProperty(pti,
              currSpecies,
              offset,
-             write_real_comp, real_comp_names);
+             write_real_comp, real_comp_names,
+             momentum_factor, share_soa);
 
          offset += numParticleOnTile64;
       }
     }
-    m_Series->flush();
+    FlushIfSync();
+    if (m_Async && pc_filtered) m_PendingParticles.push_back(std::move(pc_filtered));
 }
 
 void
@@ -423,7 +520,9 @@ WarpXOpenPMDPlot::SaveRealProperty(WarpXParIter& pti,
                        openPMD::ParticleSpecies& currSpecies,
                        unsigned long long const offset,
                        amrex::Vector<int> const& write_real_comp,
-                       amrex::Vector<std::string> const& real_comp_names) const
+                       amrex::Vector<std::string> const& real_comp_names,
+                       amrex::ParticleReal const momentum_factor,
+                       bool const share_soa) const
 
 {
   int numOutputReal = 0;
@@ -448,10 +547,7 @@ WarpXOpenPMDPlot::SaveRealProperty(WarpXParIter& pti,
           auto currRecord = currSpecies[record_name];
           auto currRecordComp = currRecord[component_name];
 
-          std::shared_ptr< amrex::ParticleReal > d(
-              new amrex::ParticleReal[numParticleOnTile],
-              [](amrex::ParticleReal const *p){ delete[] p; }
-          );
+          auto d = m_StagingPool.get< amrex::ParticleReal >(numParticleOnTile);
 
           for( auto kk=0; kk<numParticleOnTile; kk++ )
                d.get()[kk] = aos[kk].m_rdata.arr[AMREX_SPACEDIM+idx];
@@ -472,8 +568,24 @@ WarpXOpenPMDPlot::SaveRealProperty(WarpXParIter& pti,
           auto& currRecord = currSpecies[record_name];
           auto& currRecordComp = currRecord[component_name];
 
-          currRecordComp.storeChunk(openPMD::shareRaw(soa.GetRealData(idx)),
-              {offset}, {numParticleOnTile64});
+          bool const is_momentum = (idx == PIdx::ux || idx == PIdx::uy || idx == PIdx::uz);
+          if (is_momentum && momentum_factor != 1.0) {
+              // stage a converted copy, leaving the particle data untouched
+              currRecordComp.storeChunk(
+                  StageCopy(soa.GetRealData(idx).dataPtr(), numParticleOnTile, momentum_factor),
+                  {offset}, {numParticleOnTile64});
+          }
+          else if (!share_soa) {
+              // stage a copy, since the particles may be modified
+              // before the data are flushed
+              currRecordComp.storeChunk(
+                  StageCopy(soa.GetRealData(idx).dataPtr(), numParticleOnTile),
+                  {offset}, {numParticleOnTile64});
+          }
+          else {
+              currRecordComp.storeChunk(openPMD::shareRaw(soa.GetRealData(idx)),
+                  {offset}, {numParticleOnTile64});
+          }
       }
     }
   }
@@ -537,6 +649,7 @@ WarpXOpenPMDPlot::WriteOpenPMDFields( //const std::string& filename,
   BL_PROFILE("WarpXOpenPMDPlot::WriteOpenPMDFields()");
 
   AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_Series != nullptr, "openPMD series must be initialized");
+  WaitForPendingFlush();
 
   int const ncomp = mf.nComp();
 
@@ -669,13 +782,19 @@ WarpXOpenPMDPlot::WriteOpenPMDFields( //const std::string& filename,
       auto const chunk_size = getReversedVec( local_box.size() );
 
       // Write local data
-      double const * local_data = fab.dataPtr( icomp );
-      mesh_comp.storeChunk( openPMD::shareRaw(local_data),
-                            chunk_offset, chunk_size );
+      amrex::Real const * local_data = fab.dataPtr( icomp );
+      if( m_Async ) {
+        // snapshot the data, which will be modified before the flush
+        mesh_comp.storeChunk( StageCopy(local_data, local_box.numPts()),
+                              chunk_offset, chunk_size );
+      } else {
+        mesh_comp.storeChunk( openPMD::shareRaw(local_data),
+                              chunk_offset, chunk_size );
+      }
     }
   }
   // Flush data to disk after looping over all components
-  m_Series->flush();
+  FlushIfSync();
 }
 
 
@@ -684,20 +803,20 @@ WarpXOpenPMDPlot::WriteOpenPMDFields( //const std::string& filename,
 //
 //
 //
-WarpXParticleCounter::WarpXParticleCounter(const std::unique_ptr<WarpXParticleContainer>& pc)
+WarpXParticleCounter::WarpXParticleCounter(WarpXParticleContainer::OutputParticleContainer& pc)
 {
   m_MPISize = amrex::ParallelDescriptor::NProcs();
   m_MPIRank = amrex::ParallelDescriptor::MyProc();
 
-  m_ParticleCounterByLevel.resize(pc->finestLevel()+1);
-  m_ParticleOffsetAtRank.resize(pc->finestLevel()+1);
-  m_ParticleSizeAtRank.resize(pc->finestLevel()+1);
+  m_ParticleCounterByLevel.resize(pc.finestLevel()+1);
+  m_ParticleOffsetAtRank.resize(pc.finestLevel()+1);
+  m_ParticleSizeAtRank.resize(pc.finestLevel()+1);
 
-  for (auto currentLevel = 0; currentLevel <= pc->finestLevel(); currentLevel++)
+  for (auto currentLevel = 0; currentLevel <= pc.finestLevel(); currentLevel++)
     {
       long numParticles = 0; // numParticles in this processor
 
-      for (WarpXParIter pti(*pc, currentLevel); pti.isValid(); ++pti) {
+      for (WarpXParIter pti(pc, currentLevel); pti.isValid(); ++pti) {
     auto numParticleOnTile = pti.numParticles();
     numParticles += numParticleOnTile;
       }
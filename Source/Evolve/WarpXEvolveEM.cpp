@@ -59,6 +59,9 @@ WarpX::EvolveEM (int numsteps)
         amrex::Print() << "\nSTEP " << step+1 << " starts ...\n";
 #ifdef WARPX_USE_PY
         if (warpx_py_beforestep) warpx_py_beforestep();
+        // The Python callbacks of this step and of the previous one
+        // may have modified the particles
+        if (warpx_py_beforestep || warpx_py_afterstep) mypc->InvalidateCellBins();
 #endif
 
         if (costs[0] != nullptr)
@@ -167,11 +170,29 @@ WarpX::EvolveEM (int numsteps)
             (insitu_int > 0) && ((step+1) % insitu_int == 0);
 
         if (do_back_transformed_diagnostics) {
-            std::unique_ptr<MultiFab> cell_centered_data = nullptr;
+            // The staggered fields are passed directly: only the planes
+            // that are needed are averaged to the cell centers.
+            Vector<const MultiFab*> bt_fields;
+            std::unique_ptr<MultiFab> charge_density;
+            std::unique_ptr<MultiFab> cell_centered_data;
+            Vector<MultiFab> cell_centered_comps;
             if (WarpX::do_back_transformed_fields) {
-                cell_centered_data = GetCellCenteredData();
+                if (finest_level == 0) {
+                    charge_density = mypc->GetChargeDensity(0);
+                    bt_fields = {Efield_aux[0][0].get(), Efield_aux[0][1].get(), Efield_aux[0][2].get(),
+                                 Bfield_aux[0][0].get(), Bfield_aux[0][1].get(), Bfield_aux[0][2].get(),
+                                 current_fp[0][0].get(), current_fp[0][1].get(), current_fp[0][2].get(),
+                                 charge_density.get()};
+                } else {
+                    // With mesh refinement, use the cell-centered data averaged down to level 0
+                    cell_centered_data = GetCellCenteredData();
+                    for (int comp = 0; comp < cell_centered_data->nComp(); ++comp) {
+                        cell_centered_comps.emplace_back(*cell_centered_data, amrex::make_alias, comp, 1);
+                    }
+                    for (const auto& mf : cell_centered_comps) bt_fields.push_back(&mf);
+                }
             }
-            myBFD->writeLabFrameData(cell_centered_data.get(), *mypc, geom[0], cur_time, dt[0]);
+            myBFD->writeLabFrameData(bt_fields, *mypc, geom[0], cur_time, dt[0]);
         }
 
         bool move_j = is_synchronized || to_make_plot || to_write_openPMD || do_insitu;
@@ -332,6 +353,7 @@ WarpX::OneStep_nosub (Real cur_time)
     // product species.
     mypc->doFieldIonization();
     mypc->doCoulombCollisions();
+    mypc->doResampling();
     // Push particle from x^{n} to x^{n+1}
     //               from p^{n-1/2} to p^{n+1/2}
     // Deposit current j^{n+1/2}
@@ -427,6 +449,7 @@ WarpX::OneStep_sub1 (Real curtime)
     // Loop over species. For each ionizable species, create particles in
     // product species.
     mypc->doFieldIonization();
+    mypc->doResampling();
 
     AMREX_ALWAYS_ASSERT_WITH_MESSAGE(finest_level == 1, "Must have exactly two levels");
     const int fine_lev = 1;
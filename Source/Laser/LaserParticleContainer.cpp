@@ -143,6 +143,22 @@ LaserParticleContainer::LaserParticleContainer (AmrCore* amr_core, int ispecies,
     common_params.p_X = p_X;
     common_params.nvec = nvec;
     m_up_laser_profile->init(pp, ParmParse{"my_constants"}, common_params);
+
+    pp.query("precompute_transverse_envelope", m_precompute_envelope);
+    pp.query("antenna_coarsening", m_antenna_coarsening);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_antenna_coarsening >= 1,
+        laser_name + ".antenna_coarsening must be at least 1");
+#ifdef WARPX_DIM_RZ
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_antenna_coarsening == 1,
+        laser_name + ".antenna_coarsening is not supported in RZ geometry");
+#endif
+    if (m_precompute_envelope) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_up_laser_profile->is_separable(),
+            laser_name + ".precompute_transverse_envelope requires a separable laser profile" +
+            " (harris, or gaussian without spatio-temporal couplings)");
+        AddRealComp("laser_env_re");
+        AddRealComp("laser_env_im");
+    }
 }
 
 /* \brief Check if laser particles enter the box, and inject if necessary.
@@ -209,9 +225,10 @@ LaserParticleContainer::InitData (int lev)
 {
     // spacing of laser particles in the laser plane.
     // has to be done after geometry is set up.
-    Real S_X, S_Y;
-    ComputeSpacing(lev, S_X, S_Y);
-    ComputeWeightMobility(S_X, S_Y);
+    ComputeSpacing(lev, m_S_X, m_S_Y);
+    ComputeWeightMobility(m_S_X, m_S_Y);
+    const Real S_X = m_S_X;
+    const Real S_Y = m_S_Y;
 
     // LaserParticleContainer::position contains the initial position of the
     // laser antenna. In the boosted frame, the antenna is moving.
@@ -367,6 +384,10 @@ LaserParticleContainer::InitData (int lev)
                   np, particle_x.dataPtr(), particle_y.dataPtr(), particle_z.dataPtr(),
                   particle_ux.dataPtr(), particle_uy.dataPtr(), particle_uz.dataPtr(),
                   1, particle_w.dataPtr(), 1);
+
+    // AddNParticles sets the runtime attributes to 0: compute the transverse
+    // envelope of the new particles (and, harmlessly, of the existing ones)
+    if (m_precompute_envelope) ComputeTransverseEnvelope();
 }
 
 void
@@ -395,12 +416,25 @@ LaserParticleContainer::Evolve (int lev,
     }
 
     // Update laser profile
+#ifndef WARPX_DIM_RZ
+    UpdateLocalLaserExtent(lev);
+#endif
     m_up_laser_profile->update(t);
 
     BL_ASSERT(OnSameGrids(lev,jx));
 
     MultiFab* cost = WarpX::getCosts(lev);
 
+    // For a separable profile with precomputed transverse envelope,
+    // only the temporal factor needs to be computed at each step
+    Real factor_re = 0._rt, factor_im = 0._rt;
+    int env_re_comp = -1, env_im_comp = -1;
+    if (m_precompute_envelope) {
+        m_up_laser_profile->get_temporal_factor(t_lab, factor_re, factor_im);
+        env_re_comp = particle_comps.at("laser_env_re");
+        env_im_comp = particle_comps.at("laser_env_im");
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -446,16 +480,38 @@ LaserParticleContainer::Evolve (int lev,
             // Particle Push
             //
             BL_PROFILE_VAR_START(blp_pp);
-            // Find the coordinates of the particles in the emission plane
-            calculate_laser_plane_coordinates(pti, np,
-                                              plane_Xp.dataPtr(),
-                                              plane_Yp.dataPtr());
-
-            // Calculate the laser amplitude to be emitted,
-            // at the position of the emission plane
-            m_up_laser_profile->fill_amplitude(
-                np, plane_Xp.dataPtr(), plane_Yp.dataPtr(),
-                t_lab, amplitude_E.dataPtr());
+            if (m_precompute_envelope) {
+                // Calculate the laser amplitude to be emitted, from the
+                // temporal factor and the precomputed transverse envelope
+                ParticleReal const * AMREX_RESTRICT const env_re =
+                    pti.GetAttribs(env_re_comp).dataPtr();
+                ParticleReal const * AMREX_RESTRICT const env_im =
+                    pti.GetAttribs(env_im_comp).dataPtr();
+                Real * AMREX_RESTRICT const amplitude = amplitude_E.dataPtr();
+                amrex::ParallelFor(
+                    np,
+                    [=] AMREX_GPU_DEVICE (int i) {
+                        amplitude[i] = factor_re*env_re[i] - factor_im*env_im[i];
+                    }
+                    );
+            } else {
+                // Find the coordinates of the particles in the emission plane
+                calculate_laser_plane_coordinates(pti, np,
+                                                  plane_Xp.dataPtr(),
+                                                  plane_Yp.dataPtr());
+
+                // Calculate the laser amplitude to be emitted,
+                // at the position of the emission plane
+                if (m_antenna_coarsening > 1) {
+                    fill_amplitude_from_coarse_antenna(
+                        pti, lev, np, plane_Xp.dataPtr(), plane_Yp.dataPtr(),
+                        t_lab, amplitude_E.dataPtr());
+                } else {
+                    m_up_laser_profile->fill_amplitude(
+                        np, plane_Xp.dataPtr(), plane_Yp.dataPtr(),
+                        t_lab, amplitude_E.dataPtr());
+                }
+            }
 
             // Calculate the corresponding momentum and position for the particles
             update_laser_particle(pti, np, uxp.dataPtr(), uyp.dataPtr(),
@@ -509,10 +565,121 @@ LaserParticleContainer::Evolve (int lev,
 void
 LaserParticleContainer::PostRestart ()
 {
-    Real Sx, Sy;
     const int lev = finestLevel();
-    ComputeSpacing(lev, Sx, Sy);
-    ComputeWeightMobility(Sx, Sy);
+    ComputeSpacing(lev, m_S_X, m_S_Y);
+    ComputeWeightMobility(m_S_X, m_S_Y);
+    if (m_precompute_envelope) ComputeTransverseEnvelope();
+}
+
+void
+LaserParticleContainer::ComputeTransverseEnvelope ()
+{
+    BL_PROFILE("Laser::ComputeTransverseEnvelope()");
+
+    const int env_re_comp = particle_comps.at("laser_env_re");
+    const int env_im_comp = particle_comps.at("laser_env_im");
+
+    for (int lev = 0; lev <= finestLevel(); ++lev)
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Gpu::ManagedDeviceVector<Real> plane_Xp, plane_Yp;
+
+            for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+            {
+                const long np = pti.numParticles();
+                plane_Xp.resize(np);
+                plane_Yp.resize(np);
+
+                calculate_laser_plane_coordinates(pti, np,
+                                                  plane_Xp.dataPtr(),
+                                                  plane_Yp.dataPtr());
+                m_up_laser_profile->fill_transverse_envelope(
+                    np, plane_Xp.dataPtr(), plane_Yp.dataPtr(),
+                    pti.GetAttribs(env_re_comp).dataPtr(),
+                    pti.GetAttribs(env_im_comp).dataPtr());
+            }
+        }
+    }
+}
+
+void
+LaserParticleContainer::UpdateLocalLaserExtent (int lev)
+{
+    Real x_lo = std::numeric_limits<Real>::max();
+    Real y_lo = std::numeric_limits<Real>::max();
+    Real x_hi = std::numeric_limits<Real>::lowest();
+    Real y_hi = std::numeric_limits<Real>::lowest();
+
+    for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+    {
+        if (pti.numParticles() == 0) continue;
+
+        Real tile_x_lo, tile_x_hi, tile_y_lo, tile_y_hi;
+        GetTilePlaneExtent(pti, lev, tile_x_lo, tile_x_hi, tile_y_lo, tile_y_hi);
+        x_lo = std::min(x_lo, tile_x_lo);
+        x_hi = std::max(x_hi, tile_x_hi);
+        y_lo = std::min(y_lo, tile_y_lo);
+        y_hi = std::max(y_hi, tile_y_hi);
+    }
+
+    // With a coarse antenna, the profile is evaluated on the coarse nodes
+    // around each tile (see fill_amplitude_from_coarse_antenna), which can
+    // be up to one coarse spacing outside of the extent of the particles
+    if (m_antenna_coarsening > 1 && x_lo <= x_hi) {
+        const Real hx = m_antenna_coarsening*m_S_X;
+        x_lo -= hx;
+        x_hi += hx;
+#if (AMREX_SPACEDIM == 3)
+        const Real hy = m_antenna_coarsening*m_S_Y;
+        y_lo -= hy;
+        y_hi += hy;
+#endif
+    }
+
+    m_up_laser_profile->set_local_extent(x_lo, x_hi, y_lo, y_hi);
+}
+
+void
+LaserParticleContainer::GetTilePlaneExtent (const WarpXParIter& pti, int lev,
+                                            Real& x_lo, Real& x_hi,
+                                            Real& y_lo, Real& y_hi) const
+{
+    x_lo = std::numeric_limits<Real>::max();
+    y_lo = std::numeric_limits<Real>::max();
+    x_hi = std::numeric_limits<Real>::lowest();
+    y_hi = std::numeric_limits<Real>::lowest();
+
+    // Grow the tile by one cell, to account for the (small) motion
+    // of the antenna particles
+    const Geometry& geom = Geom(lev);
+    const RealBox rb {amrex::grow(pti.tilebox(), 1),
+                      geom.CellSize(), geom.ProbLo()};
+
+    // Project the corners of the tile on the laser plane
+    for (int c = 0; c < (1 << AMREX_SPACEDIM); ++c)
+    {
+#if (AMREX_SPACEDIM == 3)
+        const Real pos[3] = {(c & 1) ? rb.hi(0) : rb.lo(0),
+                             (c & 2) ? rb.hi(1) : rb.lo(1),
+                             (c & 4) ? rb.hi(2) : rb.lo(2)};
+#else
+        const Real pos[3] = {(c & 1) ? rb.hi(0) : rb.lo(0),
+                             0.0_rt,
+                             (c & 2) ? rb.hi(1) : rb.lo(1)};
+#endif
+        Real X = 0.0_rt, Y = 0.0_rt;
+        for (int d = 0; d < 3; ++d) {
+            X += u_X[d]*(pos[d]-position[d]);
+            Y += u_Y[d]*(pos[d]-position[d]);
+        }
+        x_lo = std::min(x_lo, X);
+        x_hi = std::max(x_hi, X);
+        y_lo = std::min(y_lo, Y);
+        y_hi = std::max(y_hi, Y);
+    }
 }
 
 void
@@ -680,3 +847,91 @@ LaserParticleContainer::update_laser_particle(WarpXParIter& pti,
         }
         );
 }
+
+/* \brief fill the laser amplitude at the position of the particles of a tile,
+ * by evaluating the laser profile on a coarse grid of the laser plane and
+ * interpolating bilinearly (linearly in 2D) to the particles.
+ *
+ * \param pti: Particle iterator
+ * \param lev: mesh refinement level
+ * \param np: number of laser particles
+ * \param pplane_Xp, pplane_Yp: pointers to arrays of particle positions
+ * in laser plane coordinate.
+ * \param t: time (lab frame)
+ * \param amplitude: Electric field amplitude at the position of each particle.
+ */
+void
+LaserParticleContainer::fill_amplitude_from_coarse_antenna (const WarpXParIter& pti, int lev,
+                                                            const int np,
+                                                            Real const * AMREX_RESTRICT const pplane_Xp,
+                                                            Real const * AMREX_RESTRICT const pplane_Yp,
+                                                            Real t,
+                                                            Real * AMREX_RESTRICT const amplitude)
+{
+    // Nodes of the coarse grid covering the tile, in laser plane coordinates.
+    // Since x_lo < x_hi, there are at least 2 nodes along each direction.
+    Real x_lo, x_hi, y_lo, y_hi;
+    GetTilePlaneExtent(pti, lev, x_lo, x_hi, y_lo, y_hi);
+
+    const Real hx = m_antenna_coarsening*m_S_X;
+    const int ix_lo = static_cast<int>(std::floor(x_lo/hx));
+    const int nx = static_cast<int>(std::ceil(x_hi/hx)) - ix_lo + 1;
+#if (AMREX_SPACEDIM == 3)
+    const Real hy = m_antenna_coarsening*m_S_Y;
+    const int iy_lo = static_cast<int>(std::floor(y_lo/hy));
+    const int ny = static_cast<int>(std::ceil(y_hi/hy)) - iy_lo + 1;
+#else
+    amrex::ignore_unused(y_lo, y_hi);
+    const Real hy = 1.0_rt;
+    const int iy_lo = 0;
+    const int ny = 1;
+#endif
+    const Real x0 = ix_lo*hx;
+    const Real y0 = iy_lo*hy;
+    const int nc = nx*ny;
+
+    Gpu::ManagedDeviceVector<Real> coarse_X(nc), coarse_Y(nc), coarse_E(nc);
+    Real * AMREX_RESTRICT const pcoarse_X = coarse_X.dataPtr();
+    Real * AMREX_RESTRICT const pcoarse_Y = coarse_Y.dataPtr();
+    Real * AMREX_RESTRICT const pcoarse_E = coarse_E.dataPtr();
+
+    amrex::ParallelFor(
+        nc,
+        [=] AMREX_GPU_DEVICE (int n) {
+            pcoarse_X[n] = x0 + (n % nx)*hx;
+#if (AMREX_SPACEDIM == 3)
+            pcoarse_Y[n] = y0 + (n / nx)*hy;
+#else
+            pcoarse_Y[n] = 0.;
+#endif
+        }
+        );
+
+    // Evaluate the laser profile on the coarse nodes only
+    m_up_laser_profile->fill_amplitude(nc, pcoarse_X, pcoarse_Y, t, pcoarse_E);
+
+    const Real inv_hx = 1._rt/hx;
+    const Real inv_hy = 1._rt/hy;
+    amrex::ParallelFor(
+        np,
+        [=] AMREX_GPU_DEVICE (int ip) {
+            Real sx = (pplane_Xp[ip] - x0)*inv_hx;
+            const int i = amrex::max(0, amrex::min(static_cast<int>(std::floor(sx)), nx-2));
+            sx -= i;
+#if (AMREX_SPACEDIM == 3)
+            Real sy = (pplane_Yp[ip] - y0)*inv_hy;
+            const int j = amrex::max(0, amrex::min(static_cast<int>(std::floor(sy)), ny-2));
+            sy -= j;
+            amplitude[ip] =
+                (1._rt-sy)*((1._rt-sx)*pcoarse_E[j*nx+i]     + sx*pcoarse_E[j*nx+i+1]) +
+                       sy *((1._rt-sx)*pcoarse_E[(j+1)*nx+i] + sx*pcoarse_E[(j+1)*nx+i+1]);
+#else
+            amrex::ignore_unused(pplane_Yp, inv_hy);
+            amplitude[ip] = (1._rt-sx)*pcoarse_E[i] + sx*pcoarse_E[i+1];
+#endif
+        }
+        );
+
+    // The coarse arrays are freed when returning
+    Gpu::synchronize();
+}
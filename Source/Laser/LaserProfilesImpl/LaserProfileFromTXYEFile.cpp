@@ -18,10 +18,43 @@
 #include <fstream>
 #include <cstdint>
 #include <algorithm>
+#include <future>
+#include <cstring>
+#include <cmath>
 
 using namespace amrex;
 using namespace WarpXLaserProfiles;
 
+namespace
+{
+    /* Returns the (inclusive) range of grid points needed to interpolate
+     * the field at any position within [lo, hi] */
+    std::pair<int,int>
+    find_index_range (const Gpu::ManagedVector<amrex::Real>& coords,
+        const int n, const bool is_grid_uniform,
+        const amrex::Real lo, const amrex::Real hi)
+    {
+        int i_lo, i_hi;
+        if(is_grid_uniform){
+            const auto c_min = coords.front();
+            const auto c_max = coords.back();
+            const auto clamp = [n](amrex::Real val){
+                return std::min(std::max(val, -1.0_rt), static_cast<amrex::Real>(n));};
+            i_lo = static_cast<int>(
+                std::floor(clamp((n-1)*(lo-c_min)/(c_max-c_min)))) - 1;
+            i_hi = static_cast<int>(
+                std::ceil(clamp((n-1)*(hi-c_min)/(c_max-c_min))));
+        }
+        else{
+            i_lo = static_cast<int>(std::distance(coords.begin(),
+                std::upper_bound(coords.begin(), coords.end(), lo))) - 1;
+            i_hi = static_cast<int>(std::distance(coords.begin(),
+                std::upper_bound(coords.begin(), coords.end(), hi)));
+        }
+        return std::make_pair(std::max(i_lo, 0), std::min(i_hi, n-1));
+    }
+}
+
 void
 FromTXYEFileLaserProfile::init (
     const amrex::ParmParse& ppl,
@@ -53,13 +86,50 @@ FromTXYEFileLaserProfile::init (
         Abort("Error! time_chunk_size must be >= 2!");
     }
 
-    //Allocate memory for E_data Vector
-    const int data_size = m_params.time_chunk_size*
-            m_params.nx*m_params.ny;
-    m_params.E_data = Gpu::ManagedVector<amrex::Real>(data_size);
-
-    //Read first time chunck
-    read_data_t_chuck(0, m_params.time_chunk_size);
+    //Each rank can read only the part of the file it needs from
+    //a memory mapping, instead of receiving all data from the I/O processor
+    ppl.query("local_read", m_params.local_read);
+
+    //Read the next time chunk in the background while the current one is used
+    //(only relevant if the file does not fit in a single chunk)
+    ppl.query("prefetch_time_chunks", m_params.prefetch_time_chunks);
+    m_params.prefetch_time_chunks = m_params.prefetch_time_chunks &&
+        (m_params.time_chunk_size < m_params.nt) && !m_params.local_read;
+
+    //By default, E_data contains the whole transverse grid
+    m_params.ix_lo = 0;
+    m_params.ix_hi = m_params.nx-1;
+    m_params.iy_lo = 0;
+    m_params.iy_hi = m_params.ny-1;
+
+    if(m_params.local_read){
+        m_params.mapped_file = std::make_unique<WarpXUtilIO::MappedFile>(
+            m_params.txye_file_name);
+        const auto data_size = static_cast<std::size_t>(m_params.nt)*
+            m_params.nx*m_params.ny*sizeof(double);
+        if(m_params.mapped_file->size() < m_params.data_offset + data_size)
+            Abort("Failed to read field data from txye file");
+
+        //The data are read at the first update, once the extent of the
+        //antenna on this rank is known (the whole grid if it is never set)
+        m_params.needed_ix_lo = m_params.ix_lo;
+        m_params.needed_ix_hi = m_params.ix_hi;
+        m_params.needed_iy_lo = m_params.iy_lo;
+        m_params.needed_iy_hi = m_params.iy_hi;
+        m_params.window_outdated = true;
+        m_params.first_time_index = 0;
+        m_params.last_time_index = -1;
+    }
+    else{
+        //Allocate memory for E_data Vector
+        const int data_size = m_params.time_chunk_size*
+                m_params.nx*m_params.ny;
+        m_params.E_data = Gpu::ManagedVector<amrex::Real>(data_size);
+
+        //Read first time chunck
+        read_data_t_chuck(0, m_params.time_chunk_size);
+        prefetch_next_t_chunk();
+    }
 
     //Copy common params
     m_common_params = params;
@@ -75,9 +145,36 @@ FromTXYEFileLaserProfile::update (amrex::Real t)
     const auto idx_t_left = idx_times.first;
     const auto idx_t_right = idx_times.second;
 
+    //Read the data again if the local window has changed
+    if(m_params.local_read && m_params.window_outdated){
+        const int t_begin = max(idx_t_left, 0);
+        read_data_t_chuck(t_begin, t_begin+m_params.time_chunk_size);
+        return;
+    }
+
     //Load data chunck if needed
     if(idx_t_right >  m_params.last_time_index){
-        read_data_t_chuck(idx_t_left, idx_t_left+m_params.time_chunk_size);
+        const int t_begin = idx_t_left;
+        const int t_end = idx_t_left+m_params.time_chunk_size;
+        if(m_params.prefetch_t_begin == t_begin){
+            //The needed chunk has been read in the background:
+            //wait for the read to complete and broadcast it
+            bool success = true;
+            if(ParallelDescriptor::IOProcessor())
+                success = m_params.prefetch_status.get();
+            if(!success) Abort("Failed to read field data from txye file");
+            set_data_t_chunk(t_begin, t_end, m_params.prefetch_buf);
+        }
+        else{
+            //The prefetched chunk (if any) is not the one we need
+            //(e.g. the timestep is larger than the chunk): discard it
+            if(ParallelDescriptor::IOProcessor() &&
+                m_params.prefetch_status.valid())
+                m_params.prefetch_status.wait();
+            read_data_t_chuck(t_begin, t_end);
+        }
+        m_params.prefetch_t_begin = -1;
+        prefetch_next_t_chunk();
     }
 }
 
@@ -210,6 +307,8 @@ FromTXYEFileLaserProfile::parse_txye_file(std::string txye_file_name)
         ParallelDescriptor::IOProcessorNumber());
     ParallelDescriptor::Barrier();
     m_params.nt = t_sizes[0]; m_params.nx = t_sizes[1]; m_params.ny = t_sizes[2];
+    m_params.data_offset = 1 + 3*sizeof(uint32_t) +
+        (t_sizes[3] + t_sizes[4] + t_sizes[5])*sizeof(double);
 
     //Broadcast coordinates
     if(!ParallelDescriptor::IOProcessor()){
@@ -252,30 +351,53 @@ FromTXYEFileLaserProfile::read_data_t_chuck(int t_begin, int t_end)
         "Reading [" << t_begin << ", " << t_end <<
         ") data chunk from " << m_params.txye_file_name << "\n";
 
+    if(m_params.local_read){
+        read_local_data_t_chunk(t_begin, t_end);
+        return;
+    }
+
+    Vector<double> buf_e;
+    if(ParallelDescriptor::IOProcessor()){
+        if(!read_raw_data_t_chunk(t_begin, t_end, buf_e))
+            Abort("Failed to read field data from txye file");
+    }
+
+    set_data_t_chunk(t_begin, t_end, buf_e);
+}
+
+bool
+FromTXYEFileLaserProfile::read_raw_data_t_chunk(
+    int t_begin, int t_end, amrex::Vector<double>& buf) const
+{
     //Indices of the first and last timestep to read
+    const auto i_first = max(0, t_begin);
+    const auto i_last = min(t_end-1, m_params.nt-1);
+
+    std::ifstream inp(m_params.txye_file_name, std::ios::binary);
+    if(!inp) return false;
+    auto skip_amount = m_params.data_offset +
+        sizeof(double)*i_first*m_params.nx*m_params.ny;
+    inp.ignore(skip_amount);
+    if(!inp) return false;
+    const int read_size = (i_last - i_first + 1)*
+        m_params.nx*m_params.ny;
+    buf.resize(read_size);
+    inp.read(reinterpret_cast<char*>(buf.dataPtr()), read_size*sizeof(double));
+    return static_cast<bool>(inp);
+}
+
+void
+FromTXYEFileLaserProfile::set_data_t_chunk(
+    int t_begin, int t_end, const amrex::Vector<double>& buf)
+{
+    //Indices of the first and last timestep contained in buf
     auto i_first = max(0, t_begin);
     auto i_last = min(t_end-1, m_params.nt-1);
-    if(i_last-i_first+1 > m_params.E_data.size())
+    if(i_last-i_first+1 > m_params.time_chunk_size)
         Abort("Data chunk to read from file is too large");
 
     if(ParallelDescriptor::IOProcessor()){
-        //Read data chunk
-        std::ifstream inp(m_params.txye_file_name, std::ios::binary);
-        if(!inp) Abort("Failed to open txye file");
-        auto skip_amount = 1 +
-            3*sizeof(uint32_t) +
-            m_params.t_coords.size()*sizeof(double) +
-            m_params.x_coords.size()*sizeof(double) +
-            m_params.y_coords.size()*sizeof(double) +
-            sizeof(double)*t_begin*m_params.nx*m_params.ny;
-        inp.ignore(skip_amount);
-        if(!inp) Abort("Failed to read field data from txye file");
-        const int read_size = (i_last - i_first + 1)*
-            m_params.nx*m_params.ny;
-        Vector<double> buf_e(read_size);
-        inp.read(reinterpret_cast<char*>(buf_e.dataPtr()), read_size*sizeof(double));
-        if(!inp) Abort("Failed to read field data from txye file");
-        std::transform(buf_e.begin(), buf_e.end(), m_params.E_data.begin(),
+        std::transform(buf.begin(), buf.end(), m_params.E_data.begin(),
             [](auto x) {return static_cast<amrex::Real>(x);} );
     }
 
@@ -289,6 +411,116 @@ FromTXYEFileLaserProfile::read_data_t_chuck(int t_begin, int t_end)
     m_params.last_time_index = i_last;
 }
 
+void
+FromTXYEFileLaserProfile::read_local_data_t_chunk(int t_begin, int t_end)
+{
+    //Indices of the first and last timestep to read
+    const auto i_first = max(0, t_begin);
+    const auto i_last = min(t_end-1, m_params.nt-1);
+
+    //Transverse window to read
+    m_params.ix_lo = m_params.needed_ix_lo;
+    m_params.ix_hi = m_params.needed_ix_hi;
+    m_params.iy_lo = m_params.needed_iy_lo;
+    m_params.iy_hi = m_params.needed_iy_hi;
+    const int nx_loc = m_params.ix_hi - m_params.ix_lo + 1;
+    const int ny_loc = m_params.iy_hi - m_params.iy_lo + 1;
+
+    //Update first and last indices
+    m_params.first_time_index = i_first;
+    m_params.last_time_index = i_last;
+    m_params.window_outdated = false;
+
+    //Empty window (no antenna particle on this rank): nothing to read
+    if(nx_loc <= 0 || ny_loc <= 0){
+        m_params.E_data.clear();
+        return;
+    }
+
+    m_params.E_data.resize(m_params.time_chunk_size*nx_loc*ny_loc);
+
+    //Copy the window from the mapped file, row by row (y is the fastest index)
+    const char* p_file = m_params.mapped_file->data() + m_params.data_offset;
+    auto p_E_data = m_params.E_data.dataPtr();
+    for(int it = i_first; it <= i_last; ++it){
+        for(int ix = m_params.ix_lo; ix <= m_params.ix_hi; ++ix){
+            const char* p_row = p_file + sizeof(double)*(
+                (static_cast<std::size_t>(it)*m_params.nx + ix)*m_params.ny +
+                m_params.iy_lo);
+            for(int iy = 0; iy < ny_loc; ++iy){
+                double val;
+                std::memcpy(&val, p_row + iy*sizeof(double), sizeof(double));
+                *(p_E_data++) = static_cast<amrex::Real>(val);
+            }
+        }
+    }
+}
+
+void
+FromTXYEFileLaserProfile::set_local_extent (
+    amrex::Real x_lo, amrex::Real x_hi,
+    amrex::Real y_lo, amrex::Real y_hi)
+{
+    if(!m_params.local_read) return;
+
+    //No antenna particle on this rank: no data are needed (empty window)
+    if(x_lo > x_hi){
+        m_params.needed_ix_lo = 0;
+        m_params.needed_ix_hi = -1;
+        m_params.needed_iy_lo = 0;
+        m_params.needed_iy_hi = -1;
+        return;
+    }
+
+    int ix_lo, ix_hi;
+    std::tie(ix_lo, ix_hi) = find_index_range(m_params.x_coords,
+        m_params.nx, m_params.is_grid_uniform, x_lo, x_hi);
+#if (AMREX_SPACEDIM == 3)
+    int iy_lo, iy_hi;
+    std::tie(iy_lo, iy_hi) = find_index_range(m_params.y_coords,
+        m_params.ny, m_params.is_grid_uniform, y_lo, y_hi);
+#else
+    amrex::ignore_unused(y_lo, y_hi);
+    const int iy_lo = 0, iy_hi = 0;
+#endif
+
+    m_params.needed_ix_lo = ix_lo;
+    m_params.needed_ix_hi = ix_hi;
+    m_params.needed_iy_lo = iy_lo;
+    m_params.needed_iy_hi = iy_hi;
+
+    //Data are read again only if the current window is too small
+    //(an empty needed window is contained in any window)
+    const bool is_contained =
+        ix_lo >= m_params.ix_lo && ix_hi <= m_params.ix_hi &&
+        iy_lo >= m_params.iy_lo && iy_hi <= m_params.iy_hi;
+    if(!is_contained) m_params.window_outdated = true;
+}
+
+void
+FromTXYEFileLaserProfile::prefetch_next_t_chunk()
+{
+    if(!m_params.prefetch_time_chunks) return;
+    if(m_params.last_time_index >= m_params.nt-1) return;
+
+    //update() loads a new chunk starting from the left time index as soon as
+    //the right time index leaves the current chunk: unless the simulation
+    //timestep is larger than the txye timestep, this is last_time_index.
+    const int t_begin = m_params.last_time_index;
+    const int t_end = t_begin + m_params.time_chunk_size;
+    m_params.prefetch_t_begin = t_begin;
+
+    if(ParallelDescriptor::IOProcessor()){
+        amrex::Print() <<
+            "Prefetching [" << t_begin << ", " << t_end <<
+            ") data chunk from " << m_params.txye_file_name << "\n";
+        m_params.prefetch_status = std::async(std::launch::async,
+            [this, t_begin, t_end](){
+                return read_raw_data_t_chunk(
+                    t_begin, t_end, m_params.prefetch_buf);});
+    }
+}
+
 void
 FromTXYEFileLaserProfile::internal_fill_amplitude_uniform(
     const int idx_t_left,
@@ -309,6 +541,12 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_uniform(
 #endif
     const auto p_E_data = m_params.E_data.dataPtr();
     const auto tmp_idx_first_time = m_params.first_time_index;
+    const auto tmp_ix_lo = m_params.ix_lo;
+    const auto tmp_nx_loc = m_params.ix_hi - m_params.ix_lo + 1;
+#if (AMREX_SPACEDIM == 3)
+    const auto tmp_iy_lo = m_params.iy_lo;
+    const auto tmp_ny_loc = m_params.iy_hi - m_params.iy_lo + 1;
+#endif
     const int idx_t_right = idx_t_left+1;
     const auto t_left = idx_t_left*
         (m_params.t_coords.back()-m_params.t_coords.front())/(m_params.nt-1) +
@@ -346,7 +584,7 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_uniform(
 #if (AMREX_SPACEDIM == 2)
         //Interpolate amplitude
         const auto idx = [=](int i, int j){
-            return (i-tmp_idx_first_time) * tmp_nx + j;
+            return (i-tmp_idx_first_time) * tmp_nx_loc + (j-tmp_ix_lo);
         };
         amplitude[i] = WarpXUtilAlgo::bilinear_interp(
             t_left, t_right,
@@ -372,8 +610,8 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_uniform(
         //Interpolate amplitude
         const auto idx = [=](int i, int j, int k){
             return
-                (i-tmp_idx_first_time)*tmp_nx*tmp_ny+
-                j*tmp_ny + k;
+                (i-tmp_idx_first_time)*tmp_nx_loc*tmp_ny_loc+
+                (j-tmp_ix_lo)*tmp_ny_loc + (k-tmp_iy_lo);
         };
         amplitude[i] = WarpXUtilAlgo::trilinear_interp(
             t_left, t_right,
@@ -413,6 +651,12 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_nonuniform(
     const int tmp_y_coords_size = static_cast<int>(m_params.y_coords.size());
     const auto p_E_data = m_params.E_data.dataPtr();
     const auto tmp_idx_first_time = m_params.first_time_index;
+    const auto tmp_ix_lo = m_params.ix_lo;
+    const auto tmp_nx_loc = m_params.ix_hi - m_params.ix_lo + 1;
+#if (AMREX_SPACEDIM == 3)
+    const auto tmp_iy_lo = m_params.iy_lo;
+    const auto tmp_ny_loc = m_params.iy_hi - m_params.iy_lo + 1;
+#endif
     const int idx_t_right = idx_t_left+1;
     const auto t_left = m_params.t_coords[idx_t_left];
     const auto t_right = m_params.t_coords[idx_t_right];
@@ -442,7 +686,7 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_nonuniform(
 #if (AMREX_SPACEDIM == 2)
         //Interpolate amplitude
         const auto idx = [=](int i, int j){
-            return (i-tmp_idx_first_time) * tmp_x_coords_size + j;
+            return (i-tmp_idx_first_time) * tmp_nx_loc + (j-tmp_ix_lo);
         };
         amplitude[i] = WarpXUtilAlgo::bilinear_interp(
             t_left, t_right,
@@ -463,8 +707,8 @@ FromTXYEFileLaserProfile::internal_fill_amplitude_nonuniform(
         //Interpolate amplitude
         const auto idx = [=](int i, int j, int k){
             return
-                (i-tmp_idx_first_time)*tmp_x_coords_size*tmp_y_coords_size+
-                j*tmp_y_coords_size + k;
+                (i-tmp_idx_first_time)*tmp_nx_loc*tmp_ny_loc+
+                (j-tmp_ix_lo)*tmp_ny_loc + (k-tmp_iy_lo);
         };
         amplitude[i] = WarpXUtilAlgo::trilinear_interp(
             t_left, t_right,
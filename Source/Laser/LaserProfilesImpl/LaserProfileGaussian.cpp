@@ -139,3 +139,77 @@ GaussianLaserProfile::fill_amplitude (
         }
         );
 }
+
+bool
+GaussianLaserProfile::is_separable () const
+{
+    return (m_params.zeta == 0._rt) && (m_params.beta == 0._rt);
+}
+
+/* \brief compute the complex transverse envelope of a Gaussian laser without
+ * spatio-temporal couplings, at particles' position
+ *
+ * \param np: number of laser particles
+ * \param Xp: pointer to first component of positions of laser particles
+ * \param Yp: pointer to second component of positions of laser particles
+ * \param envelope_re, envelope_im: pointers to arrays of complex envelope.
+ */
+void
+GaussianLaserProfile::fill_transverse_envelope (
+    const int np, Real const * AMREX_RESTRICT const Xp, Real const * AMREX_RESTRICT const Yp,
+    ParticleReal * AMREX_RESTRICT const envelope_re,
+    ParticleReal * AMREX_RESTRICT const envelope_im) const
+{
+    Complex I(0,1);
+    const Real k0 = 2.*MathConst::pi/m_common_params.wavelength;
+    const Complex diffract_factor =
+        1._rt + I * m_params.focal_distance * 2._rt/
+        ( k0 * m_params.waist * m_params.waist );
+    const Complex inv_complex_waist_2 =
+        1._rt /(m_params.waist*m_params.waist * diffract_factor );
+
+    amrex::ParallelFor(
+        np,
+        [=] AMREX_GPU_DEVICE (int i) {
+            const Complex exp_argument = - ( Xp[i]*Xp[i] + Yp[i]*Yp[i] ) * inv_complex_waist_2;
+            const Complex envelope = MathFunc::exp( exp_argument );
+            envelope_re[i] = envelope.real();
+            envelope_im[i] = envelope.imag();
+        }
+        );
+}
+
+/* \brief compute the complex temporal factor of a Gaussian laser without
+ * spatio-temporal couplings (same factors as in fill_amplitude).
+ *
+ * \param t: Current physical time
+ * \param factor_re, factor_im: complex temporal factor.
+ */
+void
+GaussianLaserProfile::get_temporal_factor (Real t, Real& factor_re, Real& factor_im) const
+{
+    Complex I(0,1);
+    const Real k0 = 2.*MathConst::pi/m_common_params.wavelength;
+    const Real inv_tau2 = 1._rt /(m_params.duration * m_params.duration);
+    const Real oscillation_phase = k0 * PhysConst::c * ( t - m_params.t_peak );
+    const Complex diffract_factor =
+        1._rt + I * m_params.focal_distance * 2._rt/
+        ( k0 * m_params.waist * m_params.waist );
+
+    // Time stretching due to the phi2 complex envelope (1 if phi2=0)
+    const Complex stretch_factor = 1._rt + 2._rt *I * m_params.phi2 * inv_tau2;
+
+    Complex prefactor =
+        m_common_params.e_max * MathFunc::exp( I * oscillation_phase );
+#if (AMREX_SPACEDIM == 3)
+    prefactor = prefactor / diffract_factor;
+#elif (AMREX_SPACEDIM == 2)
+    prefactor = prefactor / MathFunc::sqrt(diffract_factor);
+#endif
+
+    const Real dt = t - m_params.t_peak;
+    const Complex stc_exponent = 1._rt / stretch_factor * inv_tau2 * dt * dt;
+    const Complex factor = prefactor * MathFunc::exp( - stc_exponent );
+    factor_re = factor.real();
+    factor_im = factor.imag();
+}
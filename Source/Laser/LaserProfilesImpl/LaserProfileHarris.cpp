@@ -83,3 +83,69 @@ HarrisLaserProfile::fill_amplitude (
         }
         );
 }
+
+/* \brief compute the complex transverse envelope of a Harris laser,
+ * at particles' position: the spatial envelope and the phase due to
+ * the curvature of the wavefront.
+ *
+ * \param np: number of laser particles
+ * \param Xp: pointer to first component of positions of laser particles
+ * \param Yp: pointer to second component of positions of laser particles
+ * \param envelope_re, envelope_im: pointers to arrays of complex envelope.
+ */
+void
+HarrisLaserProfile::fill_transverse_envelope (
+    const int np, Real const * AMREX_RESTRICT const Xp, Real const * AMREX_RESTRICT const Yp,
+    ParticleReal * AMREX_RESTRICT const envelope_re,
+    ParticleReal * AMREX_RESTRICT const envelope_im) const
+{
+    const Real omega0 =
+        2._rt*MathConst::pi*PhysConst::c/m_common_params.wavelength;
+    const Real zR = MathConst::pi * m_params.waist*m_params.waist
+        / m_common_params.wavelength;
+    const Real wz = m_params.waist *
+        std::sqrt(1._rt + m_params.focal_distance*m_params.focal_distance/(zR*zR));
+    const Real inv_wz_2 = 1._rt/(wz*wz);
+    Real inv_Rz;
+    if (m_params.focal_distance == 0.){
+        inv_Rz = 0.;
+    } else {
+        inv_Rz = -m_params.focal_distance /
+            ( m_params.focal_distance*m_params.focal_distance + zR*zR );
+    }
+
+    amrex::ParallelFor(
+        np,
+        [=] AMREX_GPU_DEVICE (int i) {
+            const Real space_envelope =
+                std::exp(- ( Xp[i]*Xp[i] + Yp[i]*Yp[i] ) * inv_wz_2);
+            const Real arg_osc = - omega0/PhysConst::c*
+                (Xp[i]*Xp[i] + Yp[i]*Yp[i]) * inv_Rz / 2._rt;
+            envelope_re[i] = space_envelope * std::cos(arg_osc);
+            envelope_im[i] = space_envelope * std::sin(arg_osc);
+        }
+        );
+}
+
+/* \brief compute the complex temporal factor of a Harris laser:
+ * the Harris time envelope and the oscillation at the central frequency.
+ *
+ * \param t: Current physical time
+ * \param factor_re, factor_im: complex temporal factor.
+ */
+void
+HarrisLaserProfile::get_temporal_factor (Real t, Real& factor_re, Real& factor_im) const
+{
+    const Real omega0 =
+        2._rt*MathConst::pi*PhysConst::c/m_common_params.wavelength;
+    const Real arg_env = 2._rt*MathConst::pi*t/m_params.duration;
+
+    Real time_envelope = 0.;
+    if (t < m_params.duration)
+        time_envelope = 1._rt/32._rt * (10._rt - 15._rt*std::cos(arg_env) +
+                                  6._rt*std::cos(2._rt*arg_env) -
+                                  std::cos(3._rt*arg_env));
+
+    factor_re = m_common_params.e_max * time_envelope * std::cos(omega0*t);
+    factor_im = m_common_params.e_max * time_envelope * std::sin(omega0*t);
+}
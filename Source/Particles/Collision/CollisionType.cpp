@@ -7,8 +7,11 @@
 #include "CollisionType.H"
 #include "ShuffleFisherYates.H"
 #include "ElasticCollisionPerez.H"
+#include "UpdateMomentumPerezElasticBatch.H"
 #include <WarpX.H>
 
+#include <algorithm>
+
 CollisionType::CollisionType(
     const std::vector<std::string>& species_names,
     std::string const collision_name)
@@ -29,6 +32,12 @@ CollisionType::CollisionType(
     m_CoulombLog = -1.0;
     pp.query("CoulombLog", m_CoulombLog);
 
+    // sub-cycling: the collisions are performed every ndt steps
+    m_ndt = 1;
+    pp.query("ndt", m_ndt);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_ndt >= 1,
+        collision_name + ".ndt must be >= 1");
+
     for (int i=0; i<species_names.size(); i++)
     {
         if (species_names[i] == collision_species[0])
@@ -42,6 +51,10 @@ CollisionType::CollisionType(
     else
         m_isSameSpecies = false;
 
+    // batched collision kernel (CPU only)
+    m_use_batched_kernel = false;
+    amrex::ParmParse("collisions").query("use_batched_kernel", m_use_batched_kernel);
+
 }
 
 using namespace amrex;
@@ -51,41 +64,186 @@ using ParticleTileType = WarpXParticleContainer::ParticleTileType;
 using ParticleBins = DenseBins<ParticleType>;
 using index_type = ParticleBins::index_type;
 
+#ifndef AMREX_USE_GPU
 namespace {
 
-    /* Find the particles and count the particles that are in each cell.
-       Note that this does *not* rearrange particle arrays */
-    ParticleBins
-    findParticlesInEachCell( int const lev, MFIter const& mfi,
-                             ParticleTileType const& ptile) {
-
-        // Extract particle structures for this tile
-        int const np = ptile.numParticles();
-        ParticleType const* particle_ptr = ptile.GetArrayOfStructs()().data();
-
-        // Extract box properties
-        Geometry const& geom = WarpX::GetInstance().Geom(lev);
-        Box const& cbx = mfi.tilebox(IntVect::TheZeroVector()); //Cell-centered box
-        const auto lo = lbound(cbx);
-        const auto dxi = geom.InvCellSizeArray();
-        const auto plo = geom.ProbLoArray();
-
-        // Find particles that are in each cell;
-        // results are stored in the object `bins`.
-        ParticleBins bins;
-        bins.build(np, particle_ptr, cbx,
-            // Pass lambda function that returns the cell index
-            [=] AMREX_GPU_HOST_DEVICE (const ParticleType& p) noexcept -> IntVect
+    /** CPU version of the loop over the cells of a tile, in which the binary
+     * collisions of all the cells are processed in batches by
+     * UpdateMomentumPerezElasticBatch. The pairs of each cell are the same as
+     * in ElasticCollisionPerez. They are processed in rounds containing at most
+     * one pair per particle, so that a particle that belongs to several pairs
+     * (when the two groups of a cell have different sizes) is updated by each
+     * of them in turn, as in the scalar version.
+     * For the same species, the arrays of species 2 are those of species 1.
+     */
+    void doCoulombCollisionsBatched (
+        int const n_cells, bool const isSameSpecies,
+        index_type const* cell_offsets_1, index_type* indices_1,
+        index_type const* cell_offsets_2, index_type* indices_2,
+        Real* ux_1, Real* uy_1, Real* uz_1, Real const* w_1,
+        Real* ux_2, Real* uy_2, Real* uz_2, Real const* w_2,
+        Real const q1, Real const q2, Real const m1, Real const m2,
+        Real const dt, Real const CoulombLog, Real const dV,
+        Box const& cbx, ParticleType const* aos_1, ParticleType const* aos_2,
+        bool const use_counter_rng, WarpXRandom::CounterRNG const& shuffle_rng,
+        WarpXRandom::CounterRNG const& scattering_rng )
+    {
+        // Groups of particles of each cell, and parameters of the cell
+        struct CellPairs {
+            index_type s1, e1, s2, e2;
+            Real n1, n2, n12, lmdD;
+        };
+        // Shuffle the particles of a group, with the counter-based generator
+        // keyed by the global index of the cell if requested
+        auto ShuffleCell = [&] (index_type* indices, index_type const is,
+                                index_type const ie, int const i_cell, int const group)
+        {
+            if ( use_counter_rng ) {
+                IntVect const iv = cbx.atOffset(i_cell);
+                ShuffleFisherYates(indices, is, ie, shuffle_rng,
+                                   iv[0], iv[1], AMREX_D_PICK(0, 0, iv[2]), group);
+            } else {
+                ShuffleFisherYates(indices, is, ie);
+            }
+        };
+        std::vector<CellPairs> cells;
+        int nrounds = 0;
+        int max_pairs_per_round = 0;
+        for (int i_cell = 0; i_cell < n_cells; ++i_cell)
+        {
+            CellPairs c;
+            if ( isSameSpecies )
             {
-                return IntVect(AMREX_D_DECL((p.pos(0)-plo[0])*dxi[0] - lo.x,
-                                            (p.pos(1)-plo[1])*dxi[1] - lo.y,
-                                            (p.pos(2)-plo[2])*dxi[2] - lo.z));
-            });
+                index_type const cell_start = cell_offsets_1[i_cell];
+                index_type const cell_stop  = cell_offsets_1[i_cell+1];
+                // Do not collide if there is only one particle in the cell
+                if ( cell_stop - cell_start < 2 ) continue;
+                c.s1 = cell_start;
+                c.e1 = (cell_start+cell_stop)/2;
+                c.s2 = c.e1;
+                c.e2 = cell_stop;
+                ShuffleCell(indices_1, c.s1, c.e1, i_cell, 1);
+            }
+            else
+            {
+                c.s1 = cell_offsets_1[i_cell];
+                c.e1 = cell_offsets_1[i_cell+1];
+                c.s2 = cell_offsets_2[i_cell];
+                c.e2 = cell_offsets_2[i_cell+1];
+                // Do not collide if one species is missing in the cell
+                if ( c.e1 - c.s1 < 1 || c.e2 - c.s2 < 1 ) continue;
+                ShuffleCell(indices_1, c.s1, c.e1, i_cell, 1);
+                ShuffleCell(indices_2, c.s2, c.e2, i_cell, 2);
+            }
+            ComputePerezCellParameters(
+                c.s1, c.e1, c.s2, c.e2, indices_1, indices_2,
+                ux_1, uy_1, uz_1, ux_2, uy_2, uz_2, w_1, w_2,
+                q1, q2, m1, m2, Real(-1.0), Real(-1.0), CoulombLog, dV,
+                c.n1, c.n2, c.n12, c.lmdD );
+            int const nmin = std::min(c.e1 - c.s1, c.e2 - c.s2);
+            int const nmax = std::max(c.e1 - c.s1, c.e2 - c.s2);
+            nrounds = std::max(nrounds, (nmax + nmin - 1)/nmin);
+            max_pairs_per_round += nmin;
+            cells.push_back(c);
+        }
+
+        // SoA buffers of the pairs of a round
+        Vector<index_type> b_i1(max_pairs_per_round), b_i2(max_pairs_per_round);
+        Vector<Real> b_u1x(max_pairs_per_round), b_u1y(max_pairs_per_round), b_u1z(max_pairs_per_round);
+        Vector<Real> b_u2x(max_pairs_per_round), b_u2y(max_pairs_per_round), b_u2z(max_pairs_per_round);
+        Vector<Real> b_w1(max_pairs_per_round), b_w2(max_pairs_per_round);
+        Vector<Real> b_n1(max_pairs_per_round), b_n2(max_pairs_per_round);
+        Vector<Real> b_n12(max_pairs_per_round), b_lmdD(max_pairs_per_round);
+        Vector<Real> r_angle(max_pairs_per_round), r_phi(max_pairs_per_round);
+        Vector<Real> r_w1(max_pairs_per_round), r_w2(max_pairs_per_round);
+        Vector<int> resample(max_pairs_per_round);
+
+        for (int round = 0; round < nrounds; ++round)
+        {
+            // Gather the pairs of this round
+            int np = 0;
+            for (auto const& c : cells)
+            {
+                int const n1p = c.e1 - c.s1;
+                int const n2p = c.e2 - c.s2;
+                int const nmin = std::min(n1p, n2p);
+                int const k_stop = std::min((round+1)*nmin, std::max(n1p, n2p));
+                for (int k = round*nmin; k < k_stop; ++k)
+                {
+                    index_type const i1 = indices_1[ c.s1 + k % n1p ];
+                    index_type const i2 = indices_2[ c.s2 + k % n2p ];
+                    b_i1[np] = i1;            b_i2[np] = i2;
+                    b_u1x[np] = ux_1[i1];     b_u2x[np] = ux_2[i2];
+                    b_u1y[np] = uy_1[i1];     b_u2y[np] = uy_2[i2];
+                    b_u1z[np] = uz_1[i1];     b_u2z[np] = uz_2[i2];
+                    b_w1[np] = w_1[i1];       b_w2[np] = w_2[i2];
+                    b_n1[np] = c.n1;          b_n2[np] = c.n2;
+                    b_n12[np] = c.n12;        b_lmdD[np] = c.lmdD;
+                    ++np;
+                }
+            }
+            if ( use_counter_rng )
+            {
+                // The numbers of a pair are keyed by the ids of its particles
+                for (int i = 0; i < np; ++i)
+                {
+                    PerezRandom const get_random(scattering_rng,
+                        aos_1[ b_i1[i] ], aos_2[ b_i2[i] ]);
+                    r_angle[i] = get_random(0u);
+                    r_phi[i] = get_random(1u);
+                    r_w1[i] = get_random(2u);
+                    r_w2[i] = get_random(3u);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < np; ++i)
+                {
+                    r_angle[i] = amrex::Random();
+                    r_phi[i] = amrex::Random();
+                    r_w1[i] = amrex::Random();
+                    r_w2[i] = amrex::Random();
+                }
+            }
 
-        return bins;
+            UpdateMomentumPerezElasticBatch(
+                np, b_u1x.dataPtr(), b_u1y.dataPtr(), b_u1z.dataPtr(),
+                b_u2x.dataPtr(), b_u2y.dataPtr(), b_u2z.dataPtr(),
+                b_w1.dataPtr(), b_w2.dataPtr(), b_n1.dataPtr(), b_n2.dataPtr(),
+                b_n12.dataPtr(), b_lmdD.dataPtr(), q1, m1, q2, m2, dt, CoulombLog,
+                r_angle.dataPtr(), r_phi.dataPtr(), r_w1.dataPtr(), r_w2.dataPtr(),
+                resample.dataPtr() );
+
+            // Scatter the updated momenta. The pairs of a round are disjoint,
+            // so the pairs to resample can be processed in any order.
+            for (int i = 0; i < np; ++i)
+            {
+                index_type const i1 = b_i1[i];
+                index_type const i2 = b_i2[i];
+                if ( resample[i] )
+                {
+                    // With use_counter_rng, this draws the same numbers as
+                    // the batched kernel, and then the next ones
+                    UpdateMomentumPerezElastic(
+                        ux_1[i1], uy_1[i1], uz_1[i1], ux_2[i2], uy_2[i2], uz_2[i2],
+                        b_n1[i], b_n2[i], b_n12[i],
+                        q1, m1, w_1[i1], q2, m2, w_2[i2],
+                        dt, CoulombLog, b_lmdD[i],
+                        use_counter_rng ? PerezRandom(scattering_rng, aos_1[i1], aos_2[i2])
+                                        : PerezRandom() );
+                }
+                else
+                {
+                    ux_1[i1] = b_u1x[i];    ux_2[i2] = b_u2x[i];
+                    uy_1[i1] = b_u1y[i];    uy_2[i2] = b_u2y[i];
+                    uz_1[i1] = b_u1z[i];    uz_2[i2] = b_u2z[i];
+                }
+            }
+        }
     }
 
 }
+#endif
 
 /** Perform all binary collisions within a tile
  *
@@ -94,14 +252,29 @@ namespace {
  * @param species1/2 pointer to species container
  * @param isSameSpecies true if collision is between same species
  * @param CoulombLog user input Coulomb logrithm
+ * @param dt time step between two collision calls
+ * @param use_batched_kernel use the batched kernel (CPU only)
+ * @param collision_index index of the collision type, used to key the
+ *        counter-based random numbers (when warpx.use_counter_rng is set)
  *
  */
 void CollisionType::doCoulombCollisionsWithinTile
     ( int const lev, MFIter const& mfi,
     std::unique_ptr<WarpXParticleContainer>& species_1,
     std::unique_ptr<WarpXParticleContainer>& species_2,
-    bool const isSameSpecies, Real const CoulombLog )
+    bool const isSameSpecies, Real const CoulombLog, Real const dt,
+    bool const use_batched_kernel, int const collision_index )
 {
+    // Counter-based random numbers: the shuffle of a cell is keyed by the
+    // global index of the cell, the scattering of a pair by the particle ids
+    bool const use_counter_rng = WarpX::use_counter_rng;
+    int const istep = WarpX::GetInstance().getistep(0);
+    WarpXRandom::CounterRNG const shuffle_rng(WarpX::random_seed,
+        WarpXRandom::Stream::CollisionShuffle, collision_index, istep);
+    WarpXRandom::CounterRNG const scattering_rng(WarpX::random_seed,
+        WarpXRandom::Stream::CollisionScattering, collision_index, istep);
+    // Cell-centered box of the tile, on which the cell bins are built
+    Box const cbx = mfi.tilebox(IntVect::TheZeroVector());
 
     if ( isSameSpecies ) // species_1 == species_2
     {
@@ -109,7 +282,8 @@ void CollisionType::doCoulombCollisionsWithinTile
         ParticleTileType& ptile_1 = species_1->ParticlesAt(lev, mfi);
 
         // Find the particles that are in each cell of this tile
-        ParticleBins bins_1 = findParticlesInEachCell( lev, mfi, ptile_1 );
+        // (the index is shared with the other users of this species)
+        ParticleBins& bins_1 = species_1->GetCellBins( lev, mfi );
 
         // Loop over cells, and collide the particles in each cell
 
@@ -129,8 +303,9 @@ void CollisionType::doCoulombCollisionsWithinTile
         index_type const* cell_offsets_1 = bins_1.offsetsPtr();
         Real q1 = species_1->getCharge();
         Real m1 = species_1->getMass();
+        ParticleType const * const AMREX_RESTRICT aos_1 =
+            ptile_1.GetArrayOfStructs()().data();
 
-        const Real dt = WarpX::GetInstance().getdt(lev);
         Geometry const& geom = WarpX::GetInstance().Geom(lev);
         #if (AMREX_SPACEDIM == 2)
         auto dV = geom.CellSize(0) * geom.CellSize(1);
@@ -138,6 +313,20 @@ void CollisionType::doCoulombCollisionsWithinTile
         auto dV = geom.CellSize(0) * geom.CellSize(1) * geom.CellSize(2);
         #endif
 
+#ifndef AMREX_USE_GPU
+        if ( use_batched_kernel )
+        {
+            doCoulombCollisionsBatched(
+                n_cells, true, cell_offsets_1, indices_1, cell_offsets_1, indices_1,
+                ux_1, uy_1, uz_1, w_1, ux_1, uy_1, uz_1, w_1,
+                q1, q1, m1, m1, dt, CoulombLog, dV,
+                cbx, aos_1, aos_1, use_counter_rng, shuffle_rng, scattering_rng );
+            return;
+        }
+#else
+        amrex::ignore_unused(use_batched_kernel);
+#endif
+
         // Loop over cells
         amrex::ParallelFor( n_cells,
             [=] AMREX_GPU_DEVICE (int i_cell) noexcept
@@ -152,8 +341,15 @@ void CollisionType::doCoulombCollisionsWithinTile
                 if ( cell_stop_1 - cell_start_1 >= 2 )
                 {
                     // shuffle
-                    ShuffleFisherYates(
-                        indices_1, cell_start_1, cell_half_1 );
+                    if ( use_counter_rng ) {
+                        IntVect const iv = cbx.atOffset(i_cell);
+                        ShuffleFisherYates(
+                            indices_1, cell_start_1, cell_half_1, shuffle_rng,
+                            iv[0], iv[1], AMREX_D_PICK(0, 0, iv[2]), 1 );
+                    } else {
+                        ShuffleFisherYates(
+                            indices_1, cell_start_1, cell_half_1 );
+                    }
 
                     // Call the function in order to perform collisions
                     ElasticCollisionPerez(
@@ -162,7 +358,8 @@ void CollisionType::doCoulombCollisionsWithinTile
                         indices_1, indices_1,
                         ux_1, uy_1, uz_1, ux_1, uy_1, uz_1, w_1, w_1,
                         q1, q1, m1, m1, Real(-1.0), Real(-1.0),
-                        dt, CoulombLog, dV );
+                        dt, CoulombLog, dV, aos_1, aos_1,
+                        use_counter_rng, scattering_rng );
                 }
             }
         );
@@ -174,8 +371,9 @@ void CollisionType::doCoulombCollisionsWithinTile
         ParticleTileType& ptile_2 = species_2->ParticlesAt(lev, mfi);
 
         // Find the particles that are in each cell of this tile
-        ParticleBins bins_1 = findParticlesInEachCell( lev, mfi, ptile_1 );
-        ParticleBins bins_2 = findParticlesInEachCell( lev, mfi, ptile_2 );
+        // (the indices are shared with the other users of these species)
+        ParticleBins& bins_1 = species_1->GetCellBins( lev, mfi );
+        ParticleBins& bins_2 = species_2->GetCellBins( lev, mfi );
 
         // Loop over cells, and collide the particles in each cell
 
@@ -205,8 +403,11 @@ void CollisionType::doCoulombCollisionsWithinTile
         index_type const* cell_offsets_2 = bins_2.offsetsPtr();
         Real q2 = species_2->getCharge();
         Real m2 = species_2->getMass();
+        ParticleType const * const AMREX_RESTRICT aos_1 =
+            ptile_1.GetArrayOfStructs()().data();
+        ParticleType const * const AMREX_RESTRICT aos_2 =
+            ptile_2.GetArrayOfStructs()().data();
 
-        const Real dt = WarpX::GetInstance().getdt(lev);
         Geometry const& geom = WarpX::GetInstance().Geom(lev);
         #if (AMREX_SPACEDIM == 2)
         auto dV = geom.CellSize(0) * geom.CellSize(1);
@@ -214,6 +415,20 @@ void CollisionType::doCoulombCollisionsWithinTile
         auto dV = geom.CellSize(0) * geom.CellSize(1) * geom.CellSize(2);
         #endif
 
+#ifndef AMREX_USE_GPU
+        if ( use_batched_kernel )
+        {
+            doCoulombCollisionsBatched(
+                n_cells, false, cell_offsets_1, indices_1, cell_offsets_2, indices_2,
+                ux_1, uy_1, uz_1, w_1, ux_2, uy_2, uz_2, w_2,
+                q1, q2, m1, m2, dt, CoulombLog, dV,
+                cbx, aos_1, aos_2, use_counter_rng, shuffle_rng, scattering_rng );
+            return;
+        }
+#else
+        amrex::ignore_unused(use_batched_kernel);
+#endif
+
         // Loop over cells
         amrex::ParallelFor( n_cells,
             [=] AMREX_GPU_DEVICE (int i_cell) noexcept
@@ -235,8 +450,17 @@ void CollisionType::doCoulombCollisionsWithinTile
                      cell_stop_2 - cell_start_2 >= 1 )
                 {
                     // shuffle
-                    ShuffleFisherYates(indices_1, cell_start_1, cell_stop_1);
-                    ShuffleFisherYates(indices_2, cell_start_2, cell_stop_2);
+                    if ( use_counter_rng ) {
+                        IntVect const iv = cbx.atOffset(i_cell);
+                        std::uint32_t const iv_z = AMREX_D_PICK(0, 0, iv[2]);
+                        ShuffleFisherYates(indices_1, cell_start_1, cell_stop_1,
+                                           shuffle_rng, iv[0], iv[1], iv_z, 1);
+                        ShuffleFisherYates(indices_2, cell_start_2, cell_stop_2,
+                                           shuffle_rng, iv[0], iv[1], iv_z, 2);
+                    } else {
+                        ShuffleFisherYates(indices_1, cell_start_1, cell_stop_1);
+                        ShuffleFisherYates(indices_2, cell_start_2, cell_stop_2);
+                    }
 
                     // Call the function in order to perform collisions
                     ElasticCollisionPerez(
@@ -244,7 +468,8 @@ void CollisionType::doCoulombCollisionsWithinTile
                         indices_1, indices_2,
                         ux_1, uy_1, uz_1, ux_2, uy_2, uz_2, w_1, w_2,
                         q1, q2, m1, m2, Real(-1.0), Real(-1.0),
-                        dt, CoulombLog, dV );
+                        dt, CoulombLog, dV, aos_1, aos_2,
+                        use_counter_rng, scattering_rng );
                 }
             }
         );
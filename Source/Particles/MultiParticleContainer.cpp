@@ -9,6 +9,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include <MultiParticleContainer.H>
+#include <SortingUtils.H>
 
 #include <AMReX_Vector.H>
 
@@ -17,9 +18,14 @@
 //This is now needed for writing a binary file on disk.
 #include <WarpXUtil.H>
 
+#include <AMReX_Utility.H>
+
 #include <limits>
 #include <algorithm>
 #include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
 
 using namespace amrex;
 
@@ -47,8 +53,6 @@ MultiParticleContainer::MultiParticleContainer (AmrCore* amr_core)
         allcontainers[i].reset(new LaserParticleContainer(amr_core, i, lasers_names[i-nspecies]));
     }
 
-    pc_tmp.reset(new PhysicalParticleContainer(amr_core));
-
     // Compute the number of species for which lab-frame data is dumped
     // nspecies_lab_frame_diags, and map their ID to MultiParticleContainer
     // particle IDs in map_species_lab_diags.
@@ -255,7 +259,6 @@ MultiParticleContainer::AllocData ()
     for (auto& pc : allcontainers) {
         pc->AllocData();
     }
-    pc_tmp->AllocData();
 }
 
 void
@@ -264,7 +267,6 @@ MultiParticleContainer::InitData ()
     for (auto& pc : allcontainers) {
         pc->InitData();
     }
-    pc_tmp->InitData();
     // For each species, get the ID of its product species.
     // This is used for ionization and pair creation processes.
     mapSpeciesProduct();
@@ -375,6 +377,7 @@ MultiParticleContainer::Evolve (int lev,
     if (rho) rho->setVal(0.0);
     if (crho) crho->setVal(0.0);
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->Evolve(lev, Ex, Ey, Ez, Bx, By, Bz, jx, jy, jz, cjx, cjy, cjz,
                    rho, crho, cEx, cEy, cEz, cBx, cBy, cBz, t, dt, a_dt_type);
     }
@@ -384,6 +387,7 @@ void
 MultiParticleContainer::PushX (Real dt)
 {
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->PushX(dt);
     }
 }
@@ -421,10 +425,19 @@ MultiParticleContainer::SortParticlesByCell ()
     }
 }
 
+void
+MultiParticleContainer::InvalidateCellBins ()
+{
+    for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
+    }
+}
+
 void
 MultiParticleContainer::Redistribute ()
 {
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->Redistribute();
     }
 }
@@ -433,6 +446,7 @@ void
 MultiParticleContainer::RedistributeLocal (const int num_ghost)
 {
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->Redistribute(0, 0, 0, num_ghost);
     }
 }
@@ -464,6 +478,7 @@ void
 MultiParticleContainer::SetParticleBoxArray (int lev, BoxArray& new_ba)
 {
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->SetParticleBoxArray(lev,new_ba);
     }
 }
@@ -472,6 +487,7 @@ void
 MultiParticleContainer::SetParticleDistributionMap (int lev, DistributionMapping& new_dm)
 {
     for (auto& pc : allcontainers) {
+        pc->InvalidateCellBins();
         pc->SetParticleDistributionMap(lev,new_dm);
     }
 }
@@ -482,66 +498,50 @@ MultiParticleContainer::PostRestart ()
     for (auto& pc : allcontainers) {
         pc->PostRestart();
     }
-    pc_tmp->PostRestart();
 }
 
 void
 MultiParticleContainer
-::GetLabFrameData (const std::string& snapshot_name,
-                   const int i_lab, const int direction,
-                   const Real z_old, const Real z_new,
-                   const Real t_boost, const Real t_lab, const Real dt,
-                   Vector<WarpXParticleContainer::DiagnosticParticleData>& parts) const
+::GetLabFrameData (const int direction,
+                   const Vector<Real>& z_old, const Vector<Real>& z_new,
+                   const Real t_boost, const Vector<Real>& t_lab, const Real dt,
+                   Vector<Vector<WarpXParticleContainer::DiagnosticParticleData> >& parts) const
 {
 
     BL_PROFILE("MultiParticleContainer::GetLabFrameData");
 
+    const int nslices = z_new.size();
+    parts.resize(nslices);
+    for (int is = 0; is < nslices; ++is) {
+        parts[is].resize(nspecies_back_transformed_diagnostics);
+    }
+
     // Loop over particle species
     for (int i = 0; i < nspecies_back_transformed_diagnostics; ++i){
         int isp = map_species_back_transformed_diagnostics[i];
         WarpXParticleContainer* pc = allcontainers[isp].get();
-        WarpXParticleContainer::DiagnosticParticles diagnostic_particles;
+        Vector<WarpXParticleContainer::DiagnosticParticles> diagnostic_particles;
         pc->GetParticleSlice(direction, z_old, z_new, t_boost, t_lab, dt, diagnostic_particles);
-        // Here, diagnostic_particles[lev][index] is a WarpXParticleContainer::DiagnosticParticleData
-        // where "lev" is the AMR level and "index" is a [grid index][tile index] pair.
-
-        // Loop over AMR levels
-        for (int lev = 0; lev <= pc->finestLevel(); ++lev){
-            // Loop over [grid index][tile index] pairs
-            // and Fills parts[species number i] with particle data from all grids and
-            // tiles in diagnostic_particles. parts contains particles from all
-            // AMR levels indistinctly.
-            for (auto it = diagnostic_particles[lev].begin(); it != diagnostic_particles[lev].end(); ++it){
-                // it->first is the [grid index][tile index] key
-                // it->second is the corresponding
-                // WarpXParticleContainer::DiagnosticParticleData value
-                parts[i].GetRealData(DiagIdx::w).insert(  parts[i].GetRealData(DiagIdx::w  ).end(),
-                                                          it->second.GetRealData(DiagIdx::w  ).begin(),
-                                                          it->second.GetRealData(DiagIdx::w  ).end());
-
-                parts[i].GetRealData(DiagIdx::x).insert(  parts[i].GetRealData(DiagIdx::x  ).end(),
-                                                          it->second.GetRealData(DiagIdx::x  ).begin(),
-                                                          it->second.GetRealData(DiagIdx::x  ).end());
-
-                parts[i].GetRealData(DiagIdx::y).insert(  parts[i].GetRealData(DiagIdx::y  ).end(),
-                                                          it->second.GetRealData(DiagIdx::y  ).begin(),
-                                                          it->second.GetRealData(DiagIdx::y  ).end());
-
-                parts[i].GetRealData(DiagIdx::z).insert(  parts[i].GetRealData(DiagIdx::z  ).end(),
-                                                          it->second.GetRealData(DiagIdx::z  ).begin(),
-                                                          it->second.GetRealData(DiagIdx::z  ).end());
-
-                parts[i].GetRealData(DiagIdx::ux).insert(  parts[i].GetRealData(DiagIdx::ux).end(),
-                                                           it->second.GetRealData(DiagIdx::ux).begin(),
-                                                           it->second.GetRealData(DiagIdx::ux).end());
-
-                parts[i].GetRealData(DiagIdx::uy).insert(  parts[i].GetRealData(DiagIdx::uy).end(),
-                                                           it->second.GetRealData(DiagIdx::uy).begin(),
-                                                           it->second.GetRealData(DiagIdx::uy).end());
-
-                parts[i].GetRealData(DiagIdx::uz).insert(  parts[i].GetRealData(DiagIdx::uz).end(),
-                                                           it->second.GetRealData(DiagIdx::uz).begin(),
-                                                           it->second.GetRealData(DiagIdx::uz).end());
+        // Here, diagnostic_particles[is][lev][index] is a WarpXParticleContainer::DiagnosticParticleData
+        // where "is" is the slice, "lev" is the AMR level and "index" is a [grid index][tile index] pair.
+
+        for (int is = 0; is < nslices; ++is){
+            // Loop over AMR levels
+            for (int lev = 0; lev <= pc->finestLevel(); ++lev){
+                // Loop over [grid index][tile index] pairs
+                // and Fills parts[is][species number i] with particle data from all grids and
+                // tiles in diagnostic_particles[is]. parts contains particles from all
+                // AMR levels indistinctly.
+                for (auto it = diagnostic_particles[is][lev].begin(); it != diagnostic_particles[is][lev].end(); ++it){
+                    // it->first is the [grid index][tile index] key
+                    // it->second is the corresponding
+                    // WarpXParticleContainer::DiagnosticParticleData value
+                    for (int comp = 0; comp < DiagIdx::nattribs; ++comp){
+                        parts[is][i].GetRealData(comp).insert(parts[is][i].GetRealData(comp).end(),
+                                                              it->second.GetRealData(comp).begin(),
+                                                              it->second.GetRealData(comp).end());
+                    }
+                }
             }
         }
     }
@@ -558,6 +558,7 @@ MultiParticleContainer::ContinuousInjection (const RealBox& injection_box) const
     for (int i=0; i<nspecies+nlasers; i++){
         auto& pc = allcontainers[i];
         if (pc->do_continuous_injection){
+            pc->InvalidateCellBins();
             pc->ContinuousInjection(injection_box);
         }
     }
@@ -641,17 +642,24 @@ MultiParticleContainer::doFieldIonization ()
 {
     BL_PROFILE("MPC::doFieldIonization");
 
+    const int istep = WarpX::GetInstance().getistep(0);
+
     // Loop over all species.
     // Ionized particles in pc_source create particles in pc_product
     for (auto& pc_source : allcontainers)
     {
         if (!pc_source->do_field_ionization){ continue; }
 
+        // Sub-cycling: ionization is only evaluated every ionization_ndt steps
+        // (the ADK probability is then accumulated over ionization_ndt*dt)
+        if (istep % pc_source->ionization_ndt != 0){ continue; }
+
         auto& pc_product = allcontainers[pc_source->ionization_product];
 
         SmartCopyFactory copy_factory(*pc_source, *pc_product);
         auto phys_pc_ptr = static_cast<PhysicalParticleContainer*>(pc_source.get());
 
+        auto Ionizable = phys_pc_ptr->getIonizableFunc();
         auto Filter    = phys_pc_ptr->getIonizationFunc();
         auto Copy      = copy_factory.getSmartCopy();
         auto Transform = IonizationTransformFunc();
@@ -659,6 +667,10 @@ MultiParticleContainer::doFieldIonization ()
         pc_source ->defineAllParticleTiles();
         pc_product->defineAllParticleTiles();
 
+        // The source particles are reordered, and product particles are added
+        pc_source ->InvalidateCellBins();
+        pc_product->InvalidateCellBins();
+
         for (int lev = 0; lev <= pc_source->finestLevel(); ++lev)
         {
             auto info = getMFItInfo(*pc_source, *pc_product);
@@ -671,8 +683,14 @@ MultiParticleContainer::doFieldIonization ()
                 auto& src_tile = pc_source ->ParticlesAt(lev, mfi);
                 auto& dst_tile = pc_product->ParticlesAt(lev, mfi);
 
+                // Move the particles that are not fully ionized to the beginning
+                // of the tile, so that the fully-ionized ones are never processed
+                const long np_ionizable = partitionParticleTile(src_tile, Ionizable);
+                if (np_ionizable == 0) continue;
+
                 auto np_dst = dst_tile.numParticles();
                 auto num_added = filterCopyTransformParticles<1>(dst_tile, src_tile, np_dst,
+                                                                 static_cast<decltype(np_dst)>(np_ionizable),
                                                                  Filter, Copy, Transform);
 
                 setNewParticleIDs(dst_tile, np_dst, num_added);
@@ -681,13 +699,40 @@ MultiParticleContainer::doFieldIonization ()
     }
 }
 
+void
+MultiParticleContainer::doResampling ()
+{
+    BL_PROFILE("MPC::doResampling");
+
+    const int istep = WarpX::GetInstance().getistep(0);
+
+    for (auto& pc : allcontainers)
+    {
+        if (!pc->do_resampling) continue;
+        if (istep % pc->resampling_ndt != 0) continue;
+        for (int lev = 0; lev <= pc->finestLevel(); ++lev) {
+            pc->Resample(lev);
+        }
+        // The momenta and positions in the cells have been modified
+        pc->InvalidateCellBins();
+    }
+}
+
 void
 MultiParticleContainer::doCoulombCollisions ()
 {
     BL_PROFILE("MPC::doCoulombCollisions");
 
+    const int istep = WarpX::GetInstance().getistep(0);
+
     for (int i = 0; i < ncollisions; ++i)
     {
+        // Sub-cycling: each collision type is performed every ndt steps,
+        // with a time step ndt*dt. The steps are staggered between
+        // collision types, to balance the cost across steps.
+        const int ndt = allcollisions[i]->m_ndt;
+        if ((istep + i) % ndt != 0){ continue; }
+
         auto& species1 = allcontainers[ allcollisions[i]->m_species1_index ];
         auto& species2 = allcontainers[ allcollisions[i]->m_species2_index ];
 
@@ -698,6 +743,8 @@ MultiParticleContainer::doCoulombCollisions ()
         // Loop over refinement levels
         for (int lev = 0; lev <= species1->finestLevel(); ++lev){
 
+            const Real dt = ndt * WarpX::GetInstance().getdt(lev);
+
             // Loop over all grids/tiles at this level
 #ifdef _OPENMP
             info.SetDynamic(true);
@@ -708,7 +755,8 @@ MultiParticleContainer::doCoulombCollisions ()
                 CollisionType::doCoulombCollisionsWithinTile
                     ( lev, mfi, species1, species2,
                       allcollisions[i]->m_isSameSpecies,
-                      allcollisions[i]->m_CoulombLog );
+                      allcollisions[i]->m_CoulombLog, dt,
+                      allcollisions[i]->m_use_batched_kernel, i );
 
             }
         }
@@ -788,10 +836,23 @@ void MultiParticleContainer::InitQuantumSync ()
         if(load_table_name.empty()){
             amrex::Abort("Quantum Synchrotron table name should be provided");
         }
-        Vector<char> table_data;
-        ParallelDescriptor::ReadAndBcastFile(load_table_name, table_data);
-        ParallelDescriptor::Barrier();
-        m_shr_p_qs_engine->init_lookup_tables_from_raw_data(table_data);
+        int load_table_mmap = 0;
+        pp.query("load_table_mmap", load_table_mmap);
+        if(load_table_mmap){
+            //Each rank maps the file read-only: the ranks of a node then
+            //share the same physical copy of the table
+#ifdef AMREX_USE_GPU
+            amrex::Abort("load_table_mmap is not supported on GPU");
+#endif
+            if(!m_shr_p_qs_engine->init_lookup_tables_from_mapped_file(load_table_name))
+                amrex::Abort("Cannot use the table mapped from " + load_table_name);
+        }
+        else{
+            Vector<char> table_data;
+            ParallelDescriptor::ReadAndBcastFile(load_table_name, table_data);
+            ParallelDescriptor::Barrier();
+            m_shr_p_qs_engine->init_lookup_tables_from_raw_data(table_data);
+        }
     }
     else if(lookup_table_mode == "dummy_builtin"){
         amrex::Print() << "Built-in Quantum Synchrotron dummy table will be used. \n" ;
@@ -830,10 +891,23 @@ void MultiParticleContainer::InitBreitWheeler ()
         if(load_table_name.empty()){
             amrex::Abort("Breit Wheeler table name should be provided");
         }
-        Vector<char> table_data;
-        ParallelDescriptor::ReadAndBcastFile(load_table_name, table_data);
-        ParallelDescriptor::Barrier();
-        m_shr_p_bw_engine->init_lookup_tables_from_raw_data(table_data);
+        int load_table_mmap = 0;
+        pp.query("load_table_mmap", load_table_mmap);
+        if(load_table_mmap){
+            //Each rank maps the file read-only: the ranks of a node then
+            //share the same physical copy of the table
+#ifdef AMREX_USE_GPU
+            amrex::Abort("load_table_mmap is not supported on GPU");
+#endif
+            if(!m_shr_p_bw_engine->init_lookup_tables_from_mapped_file(load_table_name))
+                amrex::Abort("Cannot use the table mapped from " + load_table_name);
+        }
+        else{
+            Vector<char> table_data;
+            ParallelDescriptor::ReadAndBcastFile(load_table_name, table_data);
+            ParallelDescriptor::Barrier();
+            m_shr_p_bw_engine->init_lookup_tables_from_raw_data(table_data);
+        }
     }
     else if(lookup_table_mode == "dummy_builtin"){
         amrex::Print() << "Built-in Breit Wheeler dummy table will be used. \n" ;
@@ -848,6 +922,37 @@ void MultiParticleContainer::InitBreitWheeler ()
     }
 }
 
+std::string
+MultiParticleContainer::QedTableCacheFileName (const std::string& cache_dir,
+                                              const std::string& prefix,
+                                              const Vector<char>& ctrl_data) const
+{
+    //64-bit FNV-1a hash of the control parameters
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const auto c : ctrl_data){
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    std::stringstream ss;
+    ss << cache_dir << "/" << prefix << "_table_"
+       << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return ss.str();
+}
+
+bool
+MultiParticleContainer::QedReadCachedTable (const std::string& cache_file,
+                                           Vector<char>& table_data) const
+{
+    int exists = 0;
+    if(ParallelDescriptor::IOProcessor())
+        exists = FileExists(cache_file);
+    ParallelDescriptor::Bcast(&exists, 1, ParallelDescriptor::IOProcessorNumber());
+    if(!exists) return false;
+
+    ParallelDescriptor::ReadAndBcastFile(cache_file, table_data);
+    return !table_data.empty();
+}
+
 void
 MultiParticleContainer::QuantumSyncGenerateTable ()
 {
@@ -857,81 +962,95 @@ MultiParticleContainer::QuantumSyncGenerateTable ()
     if(table_name.empty())
         amrex::Abort("qed_qs.save_table_in should be provided!");
 
-    if(ParallelDescriptor::IOProcessor()){
-        PicsarQuantumSynchrotronCtrl ctrl;
-        int t_int;
-
-        // Engine paramenter: chi_part_min is the minium chi parameter to be
-        // considered by the engine. If a lepton has chi < chi_part_min,
-        // the optical depth is not evolved and photon generation is ignored
-        if(!pp.query("chi_min", ctrl.chi_part_min))
-            amrex::Abort("qed_qs.chi_min should be provided!");
-
-        //==Table parameters==
-
-        //--- sub-table 1 (1D)
-        //These parameters are used to pre-compute a function
-        //which appears in the evolution of the optical depth
-
-        //Minimun chi for the table. If a lepton has chi < chi_part_tdndt_min,
-        //chi is considered as it were equal to chi_part_tdndt_min
-        if(!pp.query("tab_dndt_chi_min", ctrl.chi_part_tdndt_min))
-            amrex::Abort("qed_qs.tab_dndt_chi_min should be provided!");
-
-        //Maximum chi for the table. If a lepton has chi > chi_part_tdndt_max,
-        //chi is considered as it were equal to chi_part_tdndt_max
-        if(!pp.query("tab_dndt_chi_max", ctrl.chi_part_tdndt_max))
-            amrex::Abort("qed_qs.tab_dndt_chi_max should be provided!");
-
-        //How many points should be used for chi in the table
-        if(!pp.query("tab_dndt_how_many", t_int))
-            amrex::Abort("qed_qs.tab_dndt_how_many should be provided!");
-        ctrl.chi_part_tdndt_how_many = t_int;
-        //------
-
-        //--- sub-table 2 (2D)
-        //These parameters are used to pre-compute a function
-        //which is used to extract the properties of the generated
-        //photons.
-
-        //Minimun chi for the table. If a lepton has chi < chi_part_tem_min,
-        //chi is considered as it were equal to chi_part_tem_min
-        if(!pp.query("tab_em_chi_min", ctrl.chi_part_tem_min))
-            amrex::Abort("qed_qs.tab_em_chi_min should be provided!");
-
-        //Maximum chi for the table. If a lepton has chi > chi_part_tem_max,
-        //chi is considered as it were equal to chi_part_tem_max
-        if(!pp.query("tab_em_chi_max", ctrl.chi_part_tem_max))
-            amrex::Abort("qed_qs.tab_em_chi_max should be provided!");
-
-        //How many points should be used for chi in the table
-        if(!pp.query("tab_em_chi_how_many", t_int))
-            amrex::Abort("qed_qs.tab_em_chi_how_many should be provided!");
-        ctrl.chi_part_tem_how_many = t_int;
-
-        //The other axis of the table is a cumulative probability distribution
-        //(corresponding to different energies of the generated particles)
-        //This parameter is the number of different points to consider
-        if(!pp.query("tab_em_prob_how_many", t_int))
-            amrex::Abort("qed_qs.tab_em_prob_how_many should be provided!");
-        ctrl.prob_tem_how_many = t_int;
-        //====================
+    PicsarQuantumSynchrotronCtrl ctrl;
+    int t_int;
+
+    // Engine paramenter: chi_part_min is the minium chi parameter to be
+    // considered by the engine. If a lepton has chi < chi_part_min,
+    // the optical depth is not evolved and photon generation is ignored
+    if(!pp.query("chi_min", ctrl.chi_part_min))
+        amrex::Abort("qed_qs.chi_min should be provided!");
+
+    //==Table parameters==
+
+    //--- sub-table 1 (1D)
+    //These parameters are used to pre-compute a function
+    //which appears in the evolution of the optical depth
+
+    //Minimun chi for the table. If a lepton has chi < chi_part_tdndt_min,
+    //chi is considered as it were equal to chi_part_tdndt_min
+    if(!pp.query("tab_dndt_chi_min", ctrl.chi_part_tdndt_min))
+        amrex::Abort("qed_qs.tab_dndt_chi_min should be provided!");
+
+    //Maximum chi for the table. If a lepton has chi > chi_part_tdndt_max,
+    //chi is considered as it were equal to chi_part_tdndt_max
+    if(!pp.query("tab_dndt_chi_max", ctrl.chi_part_tdndt_max))
+        amrex::Abort("qed_qs.tab_dndt_chi_max should be provided!");
+
+    //How many points should be used for chi in the table
+    if(!pp.query("tab_dndt_how_many", t_int))
+        amrex::Abort("qed_qs.tab_dndt_how_many should be provided!");
+    ctrl.chi_part_tdndt_how_many = t_int;
+    //------
+
+    //--- sub-table 2 (2D)
+    //These parameters are used to pre-compute a function
+    //which is used to extract the properties of the generated
+    //photons.
+
+    //Minimun chi for the table. If a lepton has chi < chi_part_tem_min,
+    //chi is considered as it were equal to chi_part_tem_min
+    if(!pp.query("tab_em_chi_min", ctrl.chi_part_tem_min))
+        amrex::Abort("qed_qs.tab_em_chi_min should be provided!");
+
+    //Maximum chi for the table. If a lepton has chi > chi_part_tem_max,
+    //chi is considered as it were equal to chi_part_tem_max
+    if(!pp.query("tab_em_chi_max", ctrl.chi_part_tem_max))
+        amrex::Abort("qed_qs.tab_em_chi_max should be provided!");
+
+    //How many points should be used for chi in the table
+    if(!pp.query("tab_em_chi_how_many", t_int))
+        amrex::Abort("qed_qs.tab_em_chi_how_many should be provided!");
+    ctrl.chi_part_tem_how_many = t_int;
+
+    //The other axis of the table is a cumulative probability distribution
+    //(corresponding to different energies of the generated particles)
+    //This parameter is the number of different points to consider
+    if(!pp.query("tab_em_prob_how_many", t_int))
+        amrex::Abort("qed_qs.tab_em_prob_how_many should be provided!");
+    ctrl.prob_tem_how_many = t_int;
+    //====================
+
+    //If requested, generated tables are cached on disk, using the control
+    //parameters as a key, so that identical tables are not re-computed
+    std::string cache_dir;
+    pp.query("table_cache_dir", cache_dir);
+    const bool use_cache = !cache_dir.empty();
+    const auto ctrl_data = QuantumSynchrotronEngine::export_ctrl_data(ctrl);
+    const std::string cache_file = QedTableCacheFileName(cache_dir, "qs", ctrl_data);
+
+    Vector<char> table_data;
+    bool is_cached = use_cache && QedReadCachedTable(cache_file, table_data) &&
+        m_shr_p_qs_engine->init_lookup_tables_from_raw_data(table_data) &&
+        QuantumSynchrotronEngine::export_ctrl_data(m_shr_p_qs_engine->get_ref_ctrl()) == ctrl_data;
 
+    if(is_cached){
+        amrex::Print() << "Lookup table read from cache " << cache_file << "\n";
+    }
+    else{
         m_shr_p_qs_engine->compute_lookup_tables(ctrl);
-        WarpXUtilIO::WriteBinaryDataOnFile(table_name,
-            m_shr_p_qs_engine->export_lookup_tables_data());
+        table_data = m_shr_p_qs_engine->export_lookup_tables_data();
     }
 
-    ParallelDescriptor::Barrier();
-    Vector<char> table_data;
-    ParallelDescriptor::ReadAndBcastFile(table_name, table_data);
-    ParallelDescriptor::Barrier();
-
-    //No need to initialize from raw data for the processor that
-    //has just generated the table
-    if(!ParallelDescriptor::IOProcessor()){
-        m_shr_p_qs_engine->init_lookup_tables_from_raw_data(table_data);
+    if(ParallelDescriptor::IOProcessor()){
+        WarpXUtilIO::WriteBinaryDataOnFile(table_name, table_data);
+        if(use_cache && !is_cached){
+            if(!UtilCreateDirectory(cache_dir, 0755))
+                CreateDirectoryFailed(cache_dir);
+            WarpXUtilIO::WriteBinaryDataOnFile(cache_file, table_data);
+        }
     }
+    ParallelDescriptor::Barrier();
 }
 
 void
@@ -943,80 +1062,94 @@ MultiParticleContainer::BreitWheelerGenerateTable ()
     if(table_name.empty())
         amrex::Abort("qed_bw.save_table_in should be provided!");
 
-    if(ParallelDescriptor::IOProcessor()){
-        PicsarBreitWheelerCtrl ctrl;
-        int t_int;
-
-        // Engine paramenter: chi_phot_min is the minium chi parameter to be
-        // considered by the engine. If a photon has chi < chi_phot_min,
-        // the optical depth is not evolved and pair generation is ignored
-        if(!pp.query("chi_min", ctrl.chi_phot_min))
-            amrex::Abort("qed_bw.chi_min should be provided!");
-
-        //==Table parameters==
-
-        //--- sub-table 1 (1D)
-        //These parameters are used to pre-compute a function
-        //which appears in the evolution of the optical depth
-
-        //Minimun chi for the table. If a photon has chi < chi_phot_tdndt_min,
-        //an analytical approximation is used.
-        if(!pp.query("tab_dndt_chi_min", ctrl.chi_phot_tdndt_min))
-            amrex::Abort("qed_bw.tab_dndt_chi_min should be provided!");
-
-        //Maximum chi for the table. If a photon has chi > chi_phot_tdndt_min,
-        //an analytical approximation is used.
-        if(!pp.query("tab_dndt_chi_max", ctrl.chi_phot_tdndt_max))
-            amrex::Abort("qed_bw.tab_dndt_chi_max should be provided!");
-
-        //How many points should be used for chi in the table
-        if(!pp.query("tab_dndt_how_many", t_int))
-            amrex::Abort("qed_bw.tab_dndt_how_many should be provided!");
-        ctrl.chi_phot_tdndt_how_many = t_int;
-        //------
-
-        //--- sub-table 2 (2D)
-        //These parameters are used to pre-compute a function
-        //which is used to extract the properties of the generated
-        //particles.
-
-        //Minimun chi for the table. If a photon has chi < chi_phot_tpair_min
-        //chi is considered as it were equal to chi_phot_tpair_min
-        if(!pp.query("tab_pair_chi_min", ctrl.chi_phot_tpair_min))
-            amrex::Abort("qed_bw.tab_pair_chi_min should be provided!");
-
-        //Maximum chi for the table. If a photon has chi > chi_phot_tpair_max
-        //chi is considered as it were equal to chi_phot_tpair_max
-        if(!pp.query("tab_pair_chi_max", ctrl.chi_phot_tpair_max))
-            amrex::Abort("qed_bw.tab_pair_chi_max should be provided!");
-
-        //How many points should be used for chi in the table
-        if(!pp.query("tab_pair_chi_how_many", t_int))
-            amrex::Abort("qed_bw.tab_pair_chi_how_many should be provided!");
-        ctrl.chi_phot_tpair_how_many = t_int;
-
-        //The other axis of the table is the fraction of the initial energy
-        //'taken away' by the most energetic particle of the pair.
-        //This parameter is the number of different fractions to consider
-        if(!pp.query("tab_pair_frac_how_many", t_int))
-            amrex::Abort("qed_bw.tab_pair_frac_how_many should be provided!");
-        ctrl.chi_frac_tpair_how_many = t_int;
-        //====================
+    PicsarBreitWheelerCtrl ctrl;
+    int t_int;
+
+    // Engine paramenter: chi_phot_min is the minium chi parameter to be
+    // considered by the engine. If a photon has chi < chi_phot_min,
+    // the optical depth is not evolved and pair generation is ignored
+    if(!pp.query("chi_min", ctrl.chi_phot_min))
+        amrex::Abort("qed_bw.chi_min should be provided!");
+
+    //==Table parameters==
+
+    //--- sub-table 1 (1D)
+    //These parameters are used to pre-compute a function
+    //which appears in the evolution of the optical depth
+
+    //Minimun chi for the table. If a photon has chi < chi_phot_tdndt_min,
+    //an analytical approximation is used.
+    if(!pp.query("tab_dndt_chi_min", ctrl.chi_phot_tdndt_min))
+        amrex::Abort("qed_bw.tab_dndt_chi_min should be provided!");
+
+    //Maximum chi for the table. If a photon has chi > chi_phot_tdndt_min,
+    //an analytical approximation is used.
+    if(!pp.query("tab_dndt_chi_max", ctrl.chi_phot_tdndt_max))
+        amrex::Abort("qed_bw.tab_dndt_chi_max should be provided!");
+
+    //How many points should be used for chi in the table
+    if(!pp.query("tab_dndt_how_many", t_int))
+        amrex::Abort("qed_bw.tab_dndt_how_many should be provided!");
+    ctrl.chi_phot_tdndt_how_many = t_int;
+    //------
+
+    //--- sub-table 2 (2D)
+    //These parameters are used to pre-compute a function
+    //which is used to extract the properties of the generated
+    //particles.
+
+    //Minimun chi for the table. If a photon has chi < chi_phot_tpair_min
+    //chi is considered as it were equal to chi_phot_tpair_min
+    if(!pp.query("tab_pair_chi_min", ctrl.chi_phot_tpair_min))
+        amrex::Abort("qed_bw.tab_pair_chi_min should be provided!");
+
+    //Maximum chi for the table. If a photon has chi > chi_phot_tpair_max
+    //chi is considered as it were equal to chi_phot_tpair_max
+    if(!pp.query("tab_pair_chi_max", ctrl.chi_phot_tpair_max))
+        amrex::Abort("qed_bw.tab_pair_chi_max should be provided!");
+
+    //How many points should be used for chi in the table
+    if(!pp.query("tab_pair_chi_how_many", t_int))
+        amrex::Abort("qed_bw.tab_pair_chi_how_many should be provided!");
+    ctrl.chi_phot_tpair_how_many = t_int;
+
+    //The other axis of the table is the fraction of the initial energy
+    //'taken away' by the most energetic particle of the pair.
+    //This parameter is the number of different fractions to consider
+    if(!pp.query("tab_pair_frac_how_many", t_int))
+        amrex::Abort("qed_bw.tab_pair_frac_how_many should be provided!");
+    ctrl.chi_frac_tpair_how_many = t_int;
+    //====================
+
+    //If requested, generated tables are cached on disk, using the control
+    //parameters as a key, so that identical tables are not re-computed
+    std::string cache_dir;
+    pp.query("table_cache_dir", cache_dir);
+    const bool use_cache = !cache_dir.empty();
+    const auto ctrl_data = BreitWheelerEngine::export_ctrl_data(ctrl);
+    const std::string cache_file = QedTableCacheFileName(cache_dir, "bw", ctrl_data);
+
+    Vector<char> table_data;
+    bool is_cached = use_cache && QedReadCachedTable(cache_file, table_data) &&
+        m_shr_p_bw_engine->init_lookup_tables_from_raw_data(table_data) &&
+        BreitWheelerEngine::export_ctrl_data(m_shr_p_bw_engine->get_ref_ctrl()) == ctrl_data;
 
+    if(is_cached){
+        amrex::Print() << "Lookup table read from cache " << cache_file << "\n";
+    }
+    else{
         m_shr_p_bw_engine->compute_lookup_tables(ctrl);
-        WarpXUtilIO::WriteBinaryDataOnFile(table_name,
-            m_shr_p_bw_engine->export_lookup_tables_data());
+        table_data = m_shr_p_bw_engine->export_lookup_tables_data();
     }
 
-    ParallelDescriptor::Barrier();
-    Vector<char> table_data;
-    ParallelDescriptor::ReadAndBcastFile(table_name, table_data);
-    ParallelDescriptor::Barrier();
-
-    //No need to initialize from raw data for the processor that
-    //has just generated the table
-    if(!ParallelDescriptor::IOProcessor()){
-        m_shr_p_bw_engine->init_lookup_tables_from_raw_data(table_data);
+    if(ParallelDescriptor::IOProcessor()){
+        WarpXUtilIO::WriteBinaryDataOnFile(table_name, table_data);
+        if(use_cache && !is_cached){
+            if(!UtilCreateDirectory(cache_dir, 0755))
+                CreateDirectoryFailed(cache_dir);
+            WarpXUtilIO::WriteBinaryDataOnFile(cache_file, table_data);
+        }
     }
+    ParallelDescriptor::Barrier();
 }
 #endif
@@ -21,9 +21,34 @@
 // Import low-level single-particle kernels
 #include <UpdatePositionPhoton.H>
 #include <GetAndSetPosition.H>
+#include <SortingUtils.H>
 
 using namespace amrex;
 
+#ifdef WARPX_QED
+namespace
+{
+    /**
+     * \brief Functor that returns true for the photons with an energy
+     * above 2 m_e c^2, i.e., the only photons that can decay into a pair.
+     * u is the momentum divided by m_e, so that the energy is m_e |u| c.
+     */
+    struct AbovePairThresholdFunc
+    {
+        template <typename PData>
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        int operator() (const PData& ptd, int i) const noexcept
+        {
+            constexpr amrex::Real u2_threshold = 4.*PhysConst::c*PhysConst::c;
+            const amrex::ParticleReal ux = ptd.m_rdata[PIdx::ux][i];
+            const amrex::ParticleReal uy = ptd.m_rdata[PIdx::uy][i];
+            const amrex::ParticleReal uz = ptd.m_rdata[PIdx::uz][i];
+            return ux*ux + uy*uy + uz*uz >= u2_threshold;
+        }
+    };
+}
+#endif
+
 PhotonParticleContainer::PhotonParticleContainer (AmrCore* amr_core, int ispecies,
                                                   const std::string& name)
     : PhysicalParticleContainer(amr_core, ispecies, name)
@@ -103,19 +128,136 @@ PhotonParticleContainer::Evolve (int lev,
                                  const MultiFab* cBx, const MultiFab* cBy, const MultiFab* cBz,
                                  Real t, Real dt, DtType a_dt_type)
 {
-    // This does gather, push and depose.
-    // Push and depose have been re-written for photon,
-    // so they do not do anything.
-    PhysicalParticleContainer::Evolve (lev,
-                                       Ex, Ey, Ez,
-                                       Bx, By, Bz,
-                                       jx, jy, jz,
-                                       cjx, cjy, cjz,
-                                       rho, crho,
-                                       cEx, cEy, cEz,
-                                       cBx, cBy, cBz,
-                                       t, dt);
+#ifdef WARPX_QED
+    const bool do_gather = has_breit_wheeler();
+#else
+    const bool do_gather = false;
+#endif
+
+    // With gather buffers, some photons gather the fields from the coarse
+    // patch: use the generic path, in which push and depose have been
+    // re-written for photons, so that they do not deposit anything.
+    if (do_gather && cEx) {
+        PhysicalParticleContainer::Evolve (lev,
+                                           Ex, Ey, Ez,
+                                           Bx, By, Bz,
+                                           jx, jy, jz,
+                                           cjx, cjy, cjz,
+                                           rho, crho,
+                                           cEx, cEy, cEz,
+                                           cBx, cBy, cBz,
+                                           t, dt, a_dt_type);
+        return;
+    }
+
+    BL_PROFILE("PhotonPC::Evolve()");
+    BL_PROFILE_VAR_NS("PhotonPC::FieldGather", blp_fg);
+    BL_PROFILE_VAR_NS("PhotonPC::EvolveOpticalDepth", blp_qed_ev);
+    BL_PROFILE_VAR_NS("PhotonPC::ParticlePush", blp_pp);
+
+    // Photons have no charge: there is no need to partition them in the
+    // buffers, nor to deposit charge and current. Fields are only gathered
+    // when the optical depth of the photons is evolved, and only for the
+    // photons that can decay into a pair.
+    MultiFab* cost = WarpX::getCosts(lev);
+
+    if (WarpX::do_back_transformed_diagnostics && do_back_transformed_diagnostics)
+    {
+        for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+        {
+            const auto np = pti.numParticles();
+            const auto t_lev = pti.GetLevel();
+            const auto index = pti.GetPairIndex();
+            tmp_particle_data.resize(finestLevel()+1);
+            for (int i = 0; i < TmpIdx::nattribs; ++i)
+                tmp_particle_data[t_lev][index][i].resize(np);
+        }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        FArrayBox filtered_Ex, filtered_Ey, filtered_Ez;
+        FArrayBox filtered_Bx, filtered_By, filtered_Bz;
 
+        for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+        {
+            Real wt = amrex::second();
+
+            if (! do_not_push)
+            {
+#ifdef WARPX_QED
+                if (do_gather)
+                {
+                    // Move the photons above the pair-creation threshold
+                    // to the beginning of the tile
+                    const long np_qed = partitionParticleTile(
+                        ParticlesAt(lev, pti), AbovePairThresholdFunc());
+
+                    if (np_qed > 0)
+                    {
+                        auto& attribs = pti.GetAttribs();
+
+                        // Data on the grid
+                        FArrayBox const* exfab = &(Ex[pti]);
+                        FArrayBox const* eyfab = &(Ey[pti]);
+                        FArrayBox const* ezfab = &(Ez[pti]);
+                        FArrayBox const* bxfab = &(Bx[pti]);
+                        FArrayBox const* byfab = &(By[pti]);
+                        FArrayBox const* bzfab = &(Bz[pti]);
+
+                        Elixir exeli, eyeli, ezeli, bxeli, byeli, bzeli;
+
+                        if (WarpX::use_fdtd_nci_corr)
+                        {
+                            applyNCIFilter(lev, pti.tilebox(), exeli, eyeli, ezeli, bxeli, byeli, bzeli,
+                                           filtered_Ex, filtered_Ey, filtered_Ez,
+                                           filtered_Bx, filtered_By, filtered_Bz,
+                                           Ex[pti], Ey[pti], Ez[pti], Bx[pti], By[pti], Bz[pti],
+                                           exfab, eyfab, ezfab, bxfab, byfab, bzfab);
+                        }
+
+                        const int e_is_nodal = Ex.is_nodal() and Ey.is_nodal() and Ez.is_nodal();
+
+                        BL_PROFILE_VAR_START(blp_fg);
+                        FieldGather(pti,
+                                    attribs[PIdx::Ex], attribs[PIdx::Ey], attribs[PIdx::Ez],
+                                    attribs[PIdx::Bx], attribs[PIdx::By], attribs[PIdx::Bz],
+                                    exfab, eyfab, ezfab, bxfab, byfab, bzfab,
+                                    Ex.nGrow(), e_is_nodal,
+                                    0, np_qed, lev, lev);
+                        BL_PROFILE_VAR_STOP(blp_fg);
+
+                        BL_PROFILE_VAR_START(blp_qed_ev);
+                        EvolveOpticalDepth(pti, dt, np_qed);
+                        BL_PROFILE_VAR_STOP(blp_qed_ev);
+                    }
+                }
+#endif
+
+                BL_PROFILE_VAR_START(blp_pp);
+                PushPX(pti, dt, a_dt_type);
+                BL_PROFILE_VAR_STOP(blp_pp);
+            }
+
+            if (cost) {
+                const Box& tbx = pti.tilebox();
+                wt = (amrex::second() - wt) / tbx.d_numPts();
+                Array4<Real> const& costarr = cost->array(pti);
+                amrex::ParallelFor(tbx,
+                                   [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+                                   {
+                                       costarr(i,j,k) += wt;
+                                   });
+            }
+        }
+    }
+
+    // Split particles at the end of the timestep (see PhysicalParticleContainer::Evolve)
+    if (do_splitting && (a_dt_type == DtType::SecondHalf || a_dt_type == DtType::Full) ){
+        SplitParticles(lev);
+    }
 }
 
 #ifdef WARPX_QED
@@ -123,6 +265,13 @@ PhotonParticleContainer::Evolve (int lev,
 void
 PhotonParticleContainer::EvolveOpticalDepth(
     WarpXParIter& pti,amrex::Real dt)
+{
+    EvolveOpticalDepth(pti, dt, pti.numParticles());
+}
+
+void
+PhotonParticleContainer::EvolveOpticalDepth(
+    WarpXParIter& pti, amrex::Real dt, long np_to_evolve)
 {
      if(!has_breit_wheeler())
         return;
@@ -147,7 +296,7 @@ PhotonParticleContainer::EvolveOpticalDepth(
     const auto me = PhysConst::m_e;
 
     amrex::ParallelFor(
-        pti.numParticles(),
+        np_to_evolve,
         [=] AMREX_GPU_DEVICE (long i) {
             const ParticleReal px = me * ux[i];
             const ParticleReal py = me * uy[i];
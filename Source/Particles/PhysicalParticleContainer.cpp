@@ -18,6 +18,10 @@
 #include <WarpX.H>
 #include <WarpXConst.H>
 #include <WarpXWrappers.h>
+#include <WarpXUtil.H>
+#include <WarpXRandom.H>
+#include <MergeParticlesInCell.H>
+#include <Splitting.H>
 #include <IonizationEnergiesTable.H>
 #include <FieldGather.H>
 #include <GetAndSetPosition.H>
@@ -55,6 +59,31 @@ PhysicalParticleContainer::PhysicalParticleContainer (AmrCore* amr_core, int isp
     pp.query("do_not_push", do_not_push);
 
     pp.query("do_continuous_injection", do_continuous_injection);
+    pp.query("use_injection_reservoir", m_use_injection_reservoir);
+
+    pp.query("do_resampling", do_resampling);
+    if (do_resampling) {
+        pp.query("resampling_ndt", resampling_ndt);
+        pp.get("resampling_max_ppc", resampling_max_ppc);
+        resampling_target_ppc = resampling_max_ppc/2;
+        pp.query("resampling_target_ppc", resampling_target_ppc);
+        pp.query("resampling_n_momentum_bins", resampling_n_momentum_bins);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(resampling_ndt >= 1,
+            "resampling_ndt must be >= 1");
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            resampling_target_ppc >= 2 && resampling_target_ppc <= resampling_max_ppc,
+            "resampling_target_ppc must be >= 2 and <= resampling_max_ppc");
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(resampling_n_momentum_bins >= 1 &&
+            resampling_n_momentum_bins <= ResamplingMaxDigitValues,
+            "resampling_n_momentum_bins must be >= 1 and <= 128");
+    }
+    if (m_use_injection_reservoir) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(WarpX::gamma_boost == 1.,
+            "use_injection_reservoir is not supported in boosted-frame simulations");
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(plasma_injector->doInjection() &&
+            plasma_injector->getInjectorDensity()->isConstant(),
+            "use_injection_reservoir requires profile = constant");
+    }
     pp.query("initialize_self_fields", initialize_self_fields);
     pp.query("self_fields_required_precision", self_fields_required_precision);
     // Whether to plot back-transformed (lab-frame) diagnostics
@@ -134,6 +163,19 @@ PhysicalParticleContainer::PhysicalParticleContainer (AmrCore* amr_core, int isp
             plot_flags[plot_flag_size-1] = 1;
         }
     #endif
+
+    // Select the particles that are dumped
+    if (pp.contains("plot_filter_function(x,y,z,ux,uy,uz,w)")) {
+        std::string str_plot_filter_function;
+        Store_parserString(pp, "plot_filter_function(x,y,z,ux,uy,uz,w)",
+                           str_plot_filter_function);
+        m_plot_filter_parser.reset(new ParserWrapper<7>(
+            makeParser(str_plot_filter_function,{"x","y","z","ux","uy","uz","w"})));
+    }
+    pp.query("plot_random_fraction", plot_random_fraction);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+        plot_random_fraction > 0. && plot_random_fraction <= 1.,
+        "plot_random_fraction must be in (0, 1]");
 }
 
 PhysicalParticleContainer::PhysicalParticleContainer (AmrCore* amr_core)
@@ -411,6 +453,10 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
     bool radially_weighted = plasma_injector->radially_weighted;
 #endif
 
+    // Next particle id: each tile reserves the ids of its new particles
+    // with an atomic fetch-add, and NextID is updated after the loop.
+    int next_pid = ParticleType::NextID();
+
     MFItInfo info;
     if (do_tiling && Gpu::notInLaunchRegion()) {
         info.EnableTiling(tile_size);
@@ -462,45 +508,166 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
         const int grid_id = mfi.index();
         const int tile_id = mfi.LocalTileIndex();
 
-        // Max number of new particles, if particles are created in the whole
-        // overlap_box. All of them are created, and invalid ones are then
-        // discaded
-        int max_new_particles = overlap_box.numPts() * num_ppc;
-
-        // If refine injection, build pointer dp_cellid that holds pointer to
-        // array of refined cell IDs.
-        Vector<int> cellid_v;
+        // If refine injection, the cells of overlap_box that are covered by
+        // the fine level get AMREX_D_TERM(rrfac,*rrfac,*rrfac) times more
+        // particles.
+        Box fine_overlap_box;
         if (refine_injection and lev == 0)
         {
-            // then how many new particles will be injected is not that simple
             // We have to shift fine_injection_box because overlap_box has been shifted.
-            Box fine_overlap_box = overlap_box & amrex::shift(fine_injection_box,shifted);
-            if (fine_overlap_box.ok()) {
-                max_new_particles += fine_overlap_box.numPts() * num_ppc
-                    * (AMREX_D_TERM(rrfac,*rrfac,*rrfac)-1);
-                for (int icell = 0, ncells = overlap_box.numPts(); icell < ncells; ++icell) {
-                    IntVect iv = overlap_box.atOffset(icell);
-                    int r = (fine_overlap_box.contains(iv)) ? AMREX_D_TERM(rrfac,*rrfac,*rrfac) : 1;
-                    for (int ipart = 0; ipart < r; ++ipart) {
-                        cellid_v.push_back(icell);
-                        cellid_v.push_back(ipart);
+            fine_overlap_box = overlap_box & amrex::shift(fine_injection_box,shifted);
+        }
+        const bool do_refine = fine_overlap_box.ok();
+        const int num_ppc_fine = num_ppc*AMREX_D_TERM(rrfac,*rrfac,*rrfac);
+        const int lrrfac = rrfac;
+
+        const GpuArray<Real,AMREX_SPACEDIM> overlap_corner
+            {AMREX_D_DECL(overlap_realbox.lo(0),
+                          overlap_realbox.lo(1),
+                          overlap_realbox.lo(2))};
+
+        // With use_counter_rng, the random numbers drawn for the position
+        // of a new particle are keyed by its global cell and its index in
+        // the cell (see WarpXRandom.H), so that the same particle is
+        // generated by the counting and the filling passes below. Otherwise,
+        // they are drawn with amrex::Random in the filling pass only.
+        const bool loc_use_counter_rng = WarpX::use_counter_rng;
+        const int istep = WarpX::GetInstance().getistep(0);
+        const WarpXRandom::CounterRNG injection_rng(WarpX::random_seed,
+            WarpXRandom::Stream::Injection, species_id, istep);
+#ifdef WARPX_DIM_RZ
+        const bool random_theta = (nmodes == 1);
+#else
+        const bool random_theta = false;
+#endif
+        // Whether getPlasmaPosition (below) draws no random number with
+        // amrex::Random, so that it can be called in both passes
+        const bool exact_count = loc_use_counter_rng ||
+            (!inj_pos->isRandom() && !random_theta);
+
+        // Generate the position of the particle i_part of the cell iv of
+        // overlap_box, and return whether this particle is injected. In a
+        // boosted-frame simulation, the bounds and the density are checked
+        // after the momentum is drawn (see below), and dens is not set.
+        auto getPlasmaPosition = [=] AMREX_GPU_HOST_DEVICE (
+            IntVect const& iv, int const i_part, int const fac,
+            Real& x, Real& y, Real& z, Real& xb, Real& yb,
+            Real& theta, Real& dens) noexcept -> bool
+        {
+            const IntVect iv_glob = iv + shifted;
+            const std::uint32_t c0 = static_cast<std::uint32_t>(iv_glob[0]);
+            const std::uint32_t c1 = static_cast<std::uint32_t>(iv_glob[1]);
+            const std::uint32_t c2 = static_cast<std::uint32_t>(AMREX_D_PICK(0, 0, iv_glob[2]));
+            const std::uint32_t c3 = 4u*static_cast<std::uint32_t>(i_part);
+            // (without use_counter_rng, the random injector draws its own
+            // numbers, and the regular one draws none)
+            const XDim3 r = loc_use_counter_rng ?
+                inj_pos->getPositionUnitBox(i_part, fac,
+                    XDim3{static_cast<Real>(injection_rng.uniform(c0, c1, c2, c3)),
+                          static_cast<Real>(injection_rng.uniform(c0, c1, c2, c3+1u)),
+                          static_cast<Real>(injection_rng.uniform(c0, c1, c2, c3+2u))}) :
+                inj_pos->getPositionUnitBox(i_part, fac);
+#if (AMREX_SPACEDIM == 3)
+            x = overlap_corner[0] + (iv[0]+r.x)*dx[0];
+            y = overlap_corner[1] + (iv[1]+r.y)*dx[1];
+            z = overlap_corner[2] + (iv[2]+r.z)*dx[2];
+#else
+            x = overlap_corner[0] + (iv[0]+r.x)*dx[0];
+            y = 0.0;
+#if   defined WARPX_DIM_XZ
+            z = overlap_corner[1] + (iv[1]+r.y)*dx[1];
+#elif defined WARPX_DIM_RZ
+            // Note that for RZ, r.y will be theta
+            z = overlap_corner[1] + (iv[1]+r.z)*dx[1];
+#endif
+#endif
+
+#if (AMREX_SPACEDIM == 3)
+            if (!tile_realbox.contains(XDim3{x,y,z})) return false;
+#else
+            if (!tile_realbox.contains(XDim3{x,z,0.0})) return false;
+#endif
+
+            // Save the x and y values to use in the insideBounds checks.
+            // This is needed with WARPX_DIM_RZ since x and y are modified.
+            xb = x;
+            yb = y;
+
+            theta = 0.;
+#ifdef WARPX_DIM_RZ
+            // Replace the x and y, setting an angle theta.
+            // These x and y are used to get the momentum and density
+            if (nmodes == 1) {
+                // With only 1 mode, the angle doesn't matter so
+                // choose it randomly.
+                theta = 2.*MathConst::pi*(loc_use_counter_rng ?
+                    injection_rng.uniform(c0, c1, c2, c3+3u) : amrex::Random());
+            } else {
+                theta = 2.*MathConst::pi*r.y;
+            }
+            x = xb*std::cos(theta);
+            y = xb*std::sin(theta);
+#endif
+
+            dens = 0.;
+            if (gamma_boost == 1.) {
+                // Lab-frame simulation
+                // If the particle is not within the species's
+                // xmin, xmax, ymin, ymax, zmin, zmax, go to
+                // the next generated particle.
+                if (!inj_pos->insideBounds(xb, yb, z)) return false;
+                dens = inj_rho->getDensity(x, y, z);
+                // Remove particle if density below threshold
+                if ( dens < density_min ) return false;
+            }
+            return true;
+        };
+
+        // First pass: count the particles injected in each cell, and
+        // compute the index of the first particle of each cell. When the
+        // positions are drawn with amrex::Random (random injector or random
+        // theta in RZ, without use_counter_rng), they cannot be drawn again,
+        // and all the candidate particles are counted instead.
+        const int ncells = overlap_box.numPts();
+        Gpu::DeviceVector<int> counts(ncells);
+        Gpu::DeviceVector<int> offsets(ncells);
+        int* const AMREX_RESTRICT p_counts = counts.dataPtr();
+        int* const AMREX_RESTRICT p_offsets = offsets.dataPtr();
+        amrex::ParallelFor(ncells, [=] AMREX_GPU_DEVICE (int icell) noexcept
+        {
+            const IntVect iv = overlap_box.atOffset(icell);
+            const bool in_fine = do_refine && fine_overlap_box.contains(iv);
+            const int n = in_fine ? num_ppc_fine : num_ppc;
+            const int fac = in_fine ? lrrfac : 1;
+            int count = n;
+            if (exact_count) {
+                count = 0;
+                for (int i_part = 0; i_part < n; ++i_part) {
+                    Real x, y, z, xb, yb, theta, dens;
+                    if (getPlasmaPosition(iv, i_part, fac, x, y, z, xb, yb, theta, dens)) {
+                        ++count;
                     }
                 }
             }
+            p_counts[icell] = count;
+        });
+
+        int num_new_particles = 0;
+        if (ncells > 0) {
+            Gpu::exclusive_scan(p_counts, p_counts+ncells, p_offsets);
+            int last_count, last_offset;
+            Gpu::copyAsync(Gpu::deviceToHost, p_counts+ncells-1, p_counts+ncells, &last_count);
+            Gpu::copyAsync(Gpu::deviceToHost, p_offsets+ncells-1, p_offsets+ncells, &last_offset);
+            Gpu::streamSynchronize();
+            num_new_particles = last_count + last_offset;
         }
-        int const* hp_cellid = (cellid_v.empty()) ? nullptr : cellid_v.data();
-        amrex::AsyncArray<int> cellid_aa(hp_cellid, cellid_v.size());
-        int const* dp_cellid = cellid_aa.data();
 
-        // Update NextID to include particles created in this function
+        // Reserve the ids of the new particles of this tile
         int pid;
 #ifdef _OPENMP
-#pragma omp critical (add_plasma_nextid)
+#pragma omp atomic capture
 #endif
-        {
-            pid = ParticleType::NextID();
-            ParticleType::NextID(pid+max_new_particles);
-        }
+        { pid = next_pid; next_pid += num_new_particles; }
         const int cpuid = ParallelDescriptor::MyProc();
 
         auto& particle_tile = GetParticles(lev)[std::make_pair(grid_id,tile_id)];
@@ -510,7 +677,7 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
         }
 
         auto old_size = particle_tile.GetArrayOfStructs().size();
-        auto new_size = old_size + max_new_particles;
+        auto new_size = old_size + num_new_particles;
         particle_tile.resize(new_size);
 
         ParticleType* pp = particle_tile.GetArrayOfStructs()().data() + old_size;
@@ -535,6 +702,8 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
         if(loc_has_quantum_sync || loc_has_breit_wheeler){
             p_tau = soa.GetRealData(particle_comps["tau"]).data() + old_size;
         }
+        const WarpXRandom::CounterRNG optical_depth_rng(WarpX::random_seed,
+            WarpXRandom::Stream::OpticalDepth, species_id, istep);
 
         //If needed, get the appropriate functors from the engines
         QuantumSynchrotronGetOpticalDepth quantum_sync_get_opt;
@@ -549,195 +718,145 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
         }
 #endif
 
-        const GpuArray<Real,AMREX_SPACEDIM> overlap_corner
-            {AMREX_D_DECL(overlap_realbox.lo(0),
-                          overlap_realbox.lo(1),
-                          overlap_realbox.lo(2))};
-
-        int lrrfac = rrfac;
-
         bool loc_do_field_ionization = do_field_ionization;
         int loc_ionization_initial_level = ionization_initial_level;
 
-        // Loop over all new particles and inject them (creates too many
-        // particles, in particular does not consider xmin, xmax etc.).
-        // The invalid ones are given negative ID and are deleted during the
-        // next redistribute.
-        amrex::For(max_new_particles, [=] AMREX_GPU_DEVICE (int ip) noexcept
+        // Second pass: generate the particles of each cell again, and fill
+        // the slots reserved for this cell. In a boosted-frame simulation,
+        // the particles that are outside of the bounds or below density_min
+        // are given negative ID, and are deleted during the next redistribute,
+        // as are the slots left empty (when all the candidates are counted).
+        amrex::ParallelFor(ncells, [=] AMREX_GPU_DEVICE (int icell) noexcept
         {
-            ParticleType& p = pp[ip];
-            p.id() = pid+ip;
-            p.cpu() = cpuid;
-
-            int cellid, i_part;
-            Real fac;
-            if (dp_cellid == nullptr) {
-                cellid = ip/num_ppc;
-                i_part = ip - cellid*num_ppc;
-                fac = 1.0;
-            } else {
-                cellid = dp_cellid[2*ip];
-                i_part = dp_cellid[2*ip+1];
-                fac = lrrfac;
-            }
-
-            IntVect iv = overlap_box.atOffset(cellid);
-
-            const XDim3 r =
-                inj_pos->getPositionUnitBox(i_part, static_cast<int>(fac));
-#if (AMREX_SPACEDIM == 3)
-            Real x = overlap_corner[0] + (iv[0]+r.x)*dx[0];
-            Real y = overlap_corner[1] + (iv[1]+r.y)*dx[1];
-            Real z = overlap_corner[2] + (iv[2]+r.z)*dx[2];
-#else
-            Real x = overlap_corner[0] + (iv[0]+r.x)*dx[0];
-            Real y = 0.0;
-#if   defined WARPX_DIM_XZ
-            Real z = overlap_corner[1] + (iv[1]+r.y)*dx[1];
-#elif defined WARPX_DIM_RZ
-            // Note that for RZ, r.y will be theta
-            Real z = overlap_corner[1] + (iv[1]+r.z)*dx[1];
-#endif
-#endif
-
-#if (AMREX_SPACEDIM == 3)
-            if (!tile_realbox.contains(XDim3{x,y,z})) {
-                p.id() = -1;
-                return;
-            }
-#else
-            if (!tile_realbox.contains(XDim3{x,z,0.0})) {
-                p.id() = -1;
-                return;
-            }
-#endif
-
-            // Save the x and y values to use in the insideBounds checks.
-            // This is needed with WARPX_DIM_RZ since x and y are modified.
-            Real xb = x;
-            Real yb = y;
-
-#ifdef WARPX_DIM_RZ
-            // Replace the x and y, setting an angle theta.
-            // These x and y are used to get the momentum and density
-            Real theta;
-            if (nmodes == 1) {
-                // With only 1 mode, the angle doesn't matter so
-                // choose it randomly.
-                theta = 2.*MathConst::pi*amrex::Random();
-            } else {
-                theta = 2.*MathConst::pi*r.y;
-            }
-            x = xb*std::cos(theta);
-            y = xb*std::sin(theta);
-#endif
-
-            Real dens;
-            XDim3 u;
-            if (gamma_boost == 1.) {
-                // Lab-frame simulation
-                // If the particle is not within the species's
-                // xmin, xmax, ymin, ymax, zmin, zmax, go to
-                // the next generated particle.
-                if (!inj_pos->insideBounds(xb, yb, z)) {
-                    p.id() = -1;
-                    return;
-                }
-                u = inj_mom->getMomentum(x, y, z);
-                dens = inj_rho->getDensity(x, y, z);
-                // Remove particle if density below threshold
-                if ( dens < density_min ){
-                    p.id() = -1;
-                    return;
-                }
-                // Cut density if above threshold
-                dens = amrex::min(dens, density_max);
-            } else {
-                // Boosted-frame simulation
-                // Since the user provides the density distribution
-                // at t_lab=0 and in the lab-frame coordinates,
-                // we need to find the lab-frame position of this
-                // particle at t_lab=0, from its boosted-frame coordinates
-                // Assuming ballistic motion, this is given by:
-                // z0_lab = gamma*( z_boost*(1-beta*betaz_lab) - ct_boost*(betaz_lab-beta) )
-                // where betaz_lab is the speed of the particle in the lab frame
-                //
-                // In order for this equation to be solvable, betaz_lab
-                // is explicitly assumed to have no dependency on z0_lab
-                u = inj_mom->getMomentum(x, y, 0.); // No z0_lab dependency
-                // At this point u is the lab-frame momentum
-                // => Apply the above formula for z0_lab
-                Real gamma_lab = std::sqrt( 1.+(u.x*u.x+u.y*u.y+u.z*u.z) );
-                Real betaz_lab = u.z/(gamma_lab);
-                Real z0_lab = gamma_boost * ( z*(1-beta_boost*betaz_lab)
-                                              - PhysConst::c*t*(betaz_lab-beta_boost) );
-                // If the particle is not within the lab-frame zmin, zmax, etc.
-                // go to the next generated particle.
-                if (!inj_pos->insideBounds(xb, yb, z0_lab)) {
-                    p.id() = -1;
-                    return;
+            const IntVect iv = overlap_box.atOffset(icell);
+            const bool in_fine = do_refine && fine_overlap_box.contains(iv);
+            const int n = in_fine ? num_ppc_fine : num_ppc;
+            const int fac = in_fine ? lrrfac : 1;
+            int ip = p_offsets[icell];
+            const int ip_end = ip + p_counts[icell];
+            for (int i_part = 0; i_part < n && ip < ip_end; ++i_part)
+            {
+                Real x, y, z, xb, yb, theta, dens;
+                if (!getPlasmaPosition(iv, i_part, fac, x, y, z, xb, yb, theta, dens)) {
+                    continue;
                 }
-                // call `getDensity` with lab-frame parameters
-                dens = inj_rho->getDensity(x, y, z0_lab);
-                // Remove particle if density below threshold
-                if ( dens < density_min ){
-                    p.id() = -1;
-                    return;
+
+                const int ipp = ip++;
+                ParticleType& p = pp[ipp];
+                p.id() = pid+ipp;
+                p.cpu() = cpuid;
+
+                XDim3 u;
+                if (gamma_boost == 1.) {
+                    // Lab-frame simulation: the bounds and the density were
+                    // checked by getPlasmaPosition
+                    u = inj_mom->getMomentum(x, y, z);
+                    // Cut density if above threshold
+                    dens = amrex::min(dens, density_max);
+                } else {
+                    // Boosted-frame simulation
+                    // Since the user provides the density distribution
+                    // at t_lab=0 and in the lab-frame coordinates,
+                    // we need to find the lab-frame position of this
+                    // particle at t_lab=0, from its boosted-frame coordinates
+                    // Assuming ballistic motion, this is given by:
+                    // z0_lab = gamma*( z_boost*(1-beta*betaz_lab) - ct_boost*(betaz_lab-beta) )
+                    // where betaz_lab is the speed of the particle in the lab frame
+                    //
+                    // In order for this equation to be solvable, betaz_lab
+                    // is explicitly assumed to have no dependency on z0_lab
+                    u = inj_mom->getMomentum(x, y, 0.); // No z0_lab dependency
+                    // At this point u is the lab-frame momentum
+                    // => Apply the above formula for z0_lab
+                    Real gamma_lab = std::sqrt( 1.+(u.x*u.x+u.y*u.y+u.z*u.z) );
+                    Real betaz_lab = u.z/(gamma_lab);
+                    Real z0_lab = gamma_boost * ( z*(1-beta_boost*betaz_lab)
+                                                  - PhysConst::c*t*(betaz_lab-beta_boost) );
+                    // If the particle is not within the lab-frame zmin, zmax, etc.
+                    // go to the next generated particle.
+                    if (!inj_pos->insideBounds(xb, yb, z0_lab)) {
+                        p.id() = -1;
+                        continue;
+                    }
+                    // call `getDensity` with lab-frame parameters
+                    dens = inj_rho->getDensity(x, y, z0_lab);
+                    // Remove particle if density below threshold
+                    if ( dens < density_min ){
+                        p.id() = -1;
+                        continue;
+                    }
+                    // Cut density if above threshold
+                    dens = amrex::min(dens, density_max);
+                    // At this point u and dens are the lab-frame quantities
+                    // => Perform Lorentz transform
+                    dens = gamma_boost * dens * ( 1.0 - beta_boost*betaz_lab );
+                    u.z = gamma_boost * ( u.z -beta_boost*gamma_lab );
                 }
-                // Cut density if above threshold
-                dens = amrex::min(dens, density_max);
-                // At this point u and dens are the lab-frame quantities
-                // => Perform Lorentz transform
-                dens = gamma_boost * dens * ( 1.0 - beta_boost*betaz_lab );
-                u.z = gamma_boost * ( u.z -beta_boost*gamma_lab );
-            }
 
-            if (loc_do_field_ionization) {
-                pi[ip] = loc_ionization_initial_level;
-            }
+                if (loc_do_field_ionization) {
+                    pi[ipp] = loc_ionization_initial_level;
+                }
 
 #ifdef WARPX_QED
-            if(loc_has_quantum_sync){
-                p_tau[ip] = quantum_sync_get_opt();
-            }
+                {
+                    const IntVect iv_glob = iv + shifted;
+                    const std::uint32_t c0 = static_cast<std::uint32_t>(iv_glob[0]);
+                    const std::uint32_t c1 = static_cast<std::uint32_t>(iv_glob[1]);
+                    const std::uint32_t c2 = static_cast<std::uint32_t>(AMREX_D_PICK(0, 0, iv_glob[2]));
+                    const std::uint32_t c3 = static_cast<std::uint32_t>(i_part);
+                    if(loc_has_quantum_sync){
+                        p_tau[ipp] = loc_use_counter_rng ?
+                            quantum_sync_get_opt(optical_depth_rng.uniform(c0, c1, c2, c3)) :
+                            quantum_sync_get_opt();
+                    }
 
-            if(loc_has_breit_wheeler){
-                p_tau[ip] = breit_wheeler_get_opt();
-            }
+                    if(loc_has_breit_wheeler){
+                        p_tau[ipp] = loc_use_counter_rng ?
+                            breit_wheeler_get_opt(optical_depth_rng.uniform(c0, c1, c2, c3)) :
+                            breit_wheeler_get_opt();
+                    }
+                }
 #endif
 
-            u.x *= PhysConst::c;
-            u.y *= PhysConst::c;
-            u.z *= PhysConst::c;
+                u.x *= PhysConst::c;
+                u.y *= PhysConst::c;
+                u.z *= PhysConst::c;
 
-            // Real weight = dens * scale_fac / (AMREX_D_TERM(fac, *fac, *fac));
-            Real weight = dens * scale_fac;
+                // Real weight = dens * scale_fac / (AMREX_D_TERM(fac, *fac, *fac));
+                Real weight = dens * scale_fac;
 #ifdef WARPX_DIM_RZ
-            if (radially_weighted) {
-                weight *= 2.*MathConst::pi*xb;
-            } else {
-                // This is not correct since it might shift the particle
-                // out of the local grid
-                x = std::sqrt(xb*rmax);
-                weight *= dx[0];
-            }
+                if (radially_weighted) {
+                    weight *= 2.*MathConst::pi*xb;
+                } else {
+                    // This is not correct since it might shift the particle
+                    // out of the local grid
+                    x = std::sqrt(xb*rmax);
+                    weight *= dx[0];
+                }
 #endif
-            pa[PIdx::w ][ip] = weight;
-            pa[PIdx::ux][ip] = u.x;
-            pa[PIdx::uy][ip] = u.y;
-            pa[PIdx::uz][ip] = u.z;
+                pa[PIdx::w ][ipp] = weight;
+                pa[PIdx::ux][ipp] = u.x;
+                pa[PIdx::uy][ipp] = u.y;
+                pa[PIdx::uz][ipp] = u.z;
 
 #if (AMREX_SPACEDIM == 3)
-            p.pos(0) = x;
-            p.pos(1) = y;
-            p.pos(2) = z;
+                p.pos(0) = x;
+                p.pos(1) = y;
+                p.pos(2) = z;
 #elif (AMREX_SPACEDIM == 2)
 #ifdef WARPX_DIM_RZ
-            pa[PIdx::theta][ip] = theta;
+                pa[PIdx::theta][ipp] = theta;
 #endif
-            p.pos(0) = xb;
-            p.pos(1) = z;
+                p.pos(0) = xb;
+                p.pos(1) = z;
 #endif
+            }
+            // Slots that were not filled (when all the candidates are
+            // counted, or should the two passes disagree, e.g. due to
+            // floating-point contraction) are discarded
+            for (; ip < ip_end; ++ip) {
+                pp[ip].id() = -1;
+            }
         });
 
         if (cost) {
@@ -751,6 +870,8 @@ PhysicalParticleContainer::AddPlasma (int lev, RealBox part_realbox)
         }
     }
 
+    ParticleType::NextID(next_pid);
+
     // The function that calls this is responsible for redistributing particles.
 }
 
@@ -1356,8 +1477,7 @@ PhysicalParticleContainer::Evolve (int lev,
     // When subcycling is ON, the splitting is done on the last call to
     // PhysicalParticleContainer::Evolve on the finest level, i.e., at the
     // end of the large timestep. Otherwise, the pushes on different levels
-    // are not consistent, and the call to Redistribute (inside
-    // SplitParticles) may result in split particles to deposit twice on the
+    // are not consistent, and split particles may deposit twice on the
     // coarse level.
     if (do_splitting && (a_dt_type == DtType::SecondHalf || a_dt_type == DtType::Full) ){
         SplitParticles(lev);
@@ -1434,171 +1554,65 @@ PhysicalParticleContainer::applyNCIFilter (
 }
 
 // Loop over all particles in the particle container and
-// split particles tagged with p.id()=DoSplitParticleID
+// split particles tagged with p.id()=DoSplitParticleID.
+// The split particles are written to the end of the tile of their parent,
+// and the parent is invalidated; particles that leave the tile are moved
+// at the next Redistribute, like after a push.
 void
 PhysicalParticleContainer::SplitParticles(int lev)
 {
-    auto& mypc = WarpX::GetInstance().GetPartContainer();
-    auto& pctmp_split = mypc.GetPCtmp();
-    RealVector psplit_x, psplit_y, psplit_z, psplit_w;
-    RealVector psplit_ux, psplit_uy, psplit_uz;
-    long np_split_to_add = 0;
-    long np_split;
-    if(split_type==0)
-    {
-        np_split = pow(2, AMREX_SPACEDIM);
-    } else {
-        np_split = 2*AMREX_SPACEDIM;
+    BL_PROFILE("PPC::SplitParticles");
+
+    const amrex::Vector<int> ppc_nd = plasma_injector->num_particles_per_cell_each_dim;
+    const std::array<Real,3>& dx = WarpX::CellSize(lev);
+    amrex::Vector<Real> split_offset = {dx[0]/2._rt,
+                                        dx[1]/2._rt,
+                                        dx[2]/2._rt};
+    if (ppc_nd[0] > 0){
+        // offset for split particles is computed as a function of cell size
+        // and number of particles per cell, so that a uniform distribution
+        // before splitting results in a uniform distribution after splitting
+        split_offset[0] /= ppc_nd[0];
+        split_offset[1] /= ppc_nd[1];
+        split_offset[2] /= ppc_nd[2];
     }
 
-    // Loop over particle interator
+    SplitTransformFunc Transform;
+    Transform.m_split_type = split_type;
+#if (AMREX_SPACEDIM==2)
+    Transform.m_offset[0] = split_offset[0];
+    Transform.m_offset[1] = split_offset[2];
+#elif (AMREX_SPACEDIM==3)
+    Transform.m_offset[0] = split_offset[0];
+    Transform.m_offset[1] = split_offset[1];
+    Transform.m_offset[2] = split_offset[2];
+#endif
+    auto Filter = SplitFilterFunc();
+    SmartCopyFactory copy_factory(*this, *this);
+    auto Copy = copy_factory.getSmartCopy();
+
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
     for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
     {
-        const auto GetPosition = GetParticlePosition(pti);
-
-        const amrex::Vector<int> ppc_nd = plasma_injector->num_particles_per_cell_each_dim;
-        const std::array<Real,3>& dx = WarpX::CellSize(lev);
-        amrex::Vector<Real> split_offset = {dx[0]/2._rt,
-                                            dx[1]/2._rt,
-                                            dx[2]/2._rt};
-        if (ppc_nd[0] > 0){
-            // offset for split particles is computed as a function of cell size
-            // and number of particles per cell, so that a uniform distribution
-            // before splitting results in a uniform distribution after splitting
-            split_offset[0] /= ppc_nd[0];
-            split_offset[1] /= ppc_nd[1];
-            split_offset[2] /= ppc_nd[2];
-        }
-        // particle Array Of Structs data
-        auto& particles = pti.GetArrayOfStructs();
-        // particle Struct Of Arrays data
-        auto& attribs = pti.GetAttribs();
-        auto& wp  = attribs[PIdx::w ];
-        auto& uxp = attribs[PIdx::ux];
-        auto& uyp = attribs[PIdx::uy];
-        auto& uzp = attribs[PIdx::uz];
-        const long np = pti.numParticles();
-        for(int i=0; i<np; i++){
-            ParticleReal xp, yp, zp;
-            GetPosition(i, xp, yp, zp);
-            auto& p = particles[i];
-            if (p.id() == DoSplitParticleID){
-                // If particle is tagged, split it and put the
-                // split particles in local arrays psplit_x etc.
-                np_split_to_add += np_split;
+        auto& ptile = ParticlesAt(lev, pti);
+        const auto np = ptile.numParticles();
+        // Split particles in two along each diagonals (2^dim copies),
+        // or in two along each axis (2*dim copies)
 #if (AMREX_SPACEDIM==2)
-                if (split_type==0){
-                    // Split particle in two along each diagonals
-                    // 4 particles in 2d
-                    for (int ishift = -1; ishift < 2; ishift +=2 ){
-                        for (int kshift = -1; kshift < 2; kshift +=2 ){
-                            // Add one particle with offset in x and z
-                            psplit_x.push_back( xp + ishift*split_offset[0] );
-                            psplit_y.push_back( yp );
-                            psplit_z.push_back( zp + kshift*split_offset[2] );
-                            psplit_ux.push_back( uxp[i] );
-                            psplit_uy.push_back( uyp[i] );
-                            psplit_uz.push_back( uzp[i] );
-                            psplit_w.push_back( wp[i]/np_split );
-                        }
-                    }
-                } else {
-                    // Split particle in two along each axis
-                    // 4 particles in 2d
-                    for (int ishift = -1; ishift < 2; ishift +=2 ){
-                        // Add one particle with offset in x
-                        psplit_x.push_back( xp + ishift*split_offset[0] );
-                        psplit_y.push_back( yp );
-                        psplit_z.push_back( zp );
-                        psplit_ux.push_back( uxp[i] );
-                        psplit_uy.push_back( uyp[i] );
-                        psplit_uz.push_back( uzp[i] );
-                        psplit_w.push_back( wp[i]/np_split );
-                        // Add one particle with offset in z
-                        psplit_x.push_back( xp );
-                        psplit_y.push_back( yp );
-                        psplit_z.push_back( zp + ishift*split_offset[2] );
-                        psplit_ux.push_back( uxp[i] );
-                        psplit_uy.push_back( uyp[i] );
-                        psplit_uz.push_back( uzp[i] );
-                        psplit_w.push_back( wp[i]/np_split );
-                    }
-                }
+        filterCopyTransformParticles<4>(ptile, ptile, np, np, Filter, Copy, Transform);
 #elif (AMREX_SPACEDIM==3)
-                if (split_type==0){
-                    // Split particle in two along each diagonals
-                    // 8 particles in 3d
-                    for (int ishift = -1; ishift < 2; ishift +=2 ){
-                        for (int jshift = -1; jshift < 2; jshift +=2 ){
-                            for (int kshift = -1; kshift < 2; kshift +=2 ){
-                                // Add one particle with offset in x, y and z
-                                psplit_x.push_back( xp + ishift*split_offset[0] );
-                                psplit_y.push_back( yp + jshift*split_offset[1] );
-                                psplit_z.push_back( zp + kshift*split_offset[2] );
-                                psplit_ux.push_back( uxp[i] );
-                                psplit_uy.push_back( uyp[i] );
-                                psplit_uz.push_back( uzp[i] );
-                                psplit_w.push_back( wp[i]/np_split );
-                            }
-                        }
-                    }
-                } else {
-                    // Split particle in two along each axis
-                    // 6 particles in 3d
-                    for (int ishift = -1; ishift < 2; ishift +=2 ){
-                        // Add one particle with offset in x
-                        psplit_x.push_back( xp + ishift*split_offset[0] );
-                        psplit_y.push_back( yp );
-                        psplit_z.push_back( zp );
-                        psplit_ux.push_back( uxp[i] );
-                        psplit_uy.push_back( uyp[i] );
-                        psplit_uz.push_back( uzp[i] );
-                        psplit_w.push_back( wp[i]/np_split );
-                        // Add one particle with offset in y
-                        psplit_x.push_back( xp );
-                        psplit_y.push_back( yp + ishift*split_offset[1] );
-                        psplit_z.push_back( zp );
-                        psplit_ux.push_back( uxp[i] );
-                        psplit_uy.push_back( uyp[i] );
-                        psplit_uz.push_back( uzp[i] );
-                        psplit_w.push_back( wp[i]/np_split );
-                        // Add one particle with offset in z
-                        psplit_x.push_back( xp );
-                        psplit_y.push_back( yp );
-                        psplit_z.push_back( zp + ishift*split_offset[2] );
-                        psplit_ux.push_back( uxp[i] );
-                        psplit_uy.push_back( uyp[i] );
-                        psplit_uz.push_back( uzp[i] );
-                        psplit_w.push_back( wp[i]/np_split );
-                    }
-                }
-#endif
-                // invalidate the particle
-                p.m_idata.id = -p.m_idata.id;
-            }
+        if (split_type==0){
+            filterCopyTransformParticles<8>(ptile, ptile, np, np, Filter, Copy, Transform);
+        } else {
+            filterCopyTransformParticles<6>(ptile, ptile, np, np, Filter, Copy, Transform);
         }
+#endif
     }
-    // Add local arrays psplit_x etc. to the temporary
-    // particle container pctmp_split. Split particles
-    // are tagged with p.id()=NoSplitParticleID so that
-    // they are not re-split when entering a higher level
-    // AddNParticles calls Redistribute, so that particles
-    // in pctmp_split are in the proper grids and tiles
-    pctmp_split.AddNParticles(lev,
-                              np_split_to_add,
-                              psplit_x.dataPtr(),
-                              psplit_y.dataPtr(),
-                              psplit_z.dataPtr(),
-                              psplit_ux.dataPtr(),
-                              psplit_uy.dataPtr(),
-                              psplit_uz.dataPtr(),
-                              1,
-                              psplit_w.dataPtr(),
-                              1, NoSplitParticleID);
-    // Copy particles from tmp to current particle container
-    addParticles(pctmp_split,1);
-    // Clear tmp container
-    pctmp_split.clearParticles();
+
+    // Particles were added to the tiles
+    InvalidateCellBins();
 }
 
 void
@@ -1940,10 +1954,12 @@ void PhysicalParticleContainer::copy_attribs (WarpXParIter& pti)
         );
 }
 
-void PhysicalParticleContainer::GetParticleSlice(const int direction, const Real z_old,
-                                                 const Real z_new, const Real t_boost,
-                                                 const Real t_lab, const Real dt,
-                                                 DiagnosticParticles& diagnostic_particles)
+void PhysicalParticleContainer::GetParticleSlice(const int direction,
+                                                 const Vector<Real>& z_old,
+                                                 const Vector<Real>& z_new,
+                                                 const Real t_boost,
+                                                 const Vector<Real>& t_lab, const Real dt,
+                                                 Vector<DiagnosticParticles>& diagnostic_particles)
 {
     BL_PROFILE("PhysicalParticleContainer::GetParticleSlice");
 
@@ -1954,24 +1970,46 @@ void PhysicalParticleContainer::GetParticleSlice(const int direction, const Real
     AMREX_ALWAYS_ASSERT(direction == 2);
 #endif
 
-    // Note the the slice should always move in the negative boost direction.
-    AMREX_ALWAYS_ASSERT(z_new < z_old);
-
     AMREX_ALWAYS_ASSERT(do_back_transformed_diagnostics == 1);
 
+    const int nslices = z_new.size();
+    AMREX_ALWAYS_ASSERT(static_cast<int>(z_old.size()) == nslices);
+    AMREX_ALWAYS_ASSERT(static_cast<int>(t_lab.size()) == nslices);
+
+    diagnostic_particles.resize(nslices);
+    if (nslices == 0) return;
+
     const int nlevs = std::max(0, finestLevel()+1);
 
+    // Position of the slices, and union of the slabs they cross, in which
+    // the particles are pre-selected.
+    Gpu::ManagedDeviceVector<Real> slice_z_old(nslices), slice_z_new(nslices);
+    Gpu::ManagedDeviceVector<Real> slice_t_lab(nslices);
+    Real z_union_min = std::numeric_limits<Real>::max();
+    Real z_union_max = std::numeric_limits<Real>::lowest();
+    for (int is = 0; is < nslices; ++is) {
+        // Note the the slice should always move in the negative boost direction.
+        AMREX_ALWAYS_ASSERT(z_new[is] < z_old[is]);
+        slice_z_old[is] = z_old[is];
+        slice_z_new[is] = z_new[is];
+        slice_t_lab[is] = t_lab[is];
+        z_union_min = std::min(z_union_min, z_new[is]);
+        z_union_max = std::max(z_union_max, z_old[is]);
+    }
+
     // we figure out a box for coarse-grained rejection. If the RealBox corresponding to a
     // given tile doesn't intersect with this, there is no need to check any particles.
     const Real* base_dx = Geom(0).CellSize();
-    const Real z_min = z_new - base_dx[direction];
-    const Real z_max = z_old + base_dx[direction];
+    const Real z_min = z_union_min - base_dx[direction];
+    const Real z_max = z_union_max + base_dx[direction];
 
     RealBox slice_box = Geom(0).ProbDomain();
     slice_box.setLo(direction, z_min);
     slice_box.setHi(direction, z_max);
 
-    diagnostic_particles.resize(finestLevel()+1);
+    for (int is = 0; is < nslices; ++is) {
+        diagnostic_particles[is].resize(finestLevel()+1);
+    }
 
     for (int lev = 0; lev < nlevs; ++lev) {
 
@@ -1982,7 +2020,9 @@ void PhysicalParticleContainer::GetParticleSlice(const int direction, const Real
         for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
         {
             auto index = std::make_pair(pti.index(), pti.LocalTileIndex());
-            diagnostic_particles[lev][index];
+            for (int is = 0; is < nslices; ++is) {
+                diagnostic_particles[is][lev][index];
+            }
         }
 
 #ifdef _OPENMP
@@ -1997,6 +2037,9 @@ void PhysicalParticleContainer::GetParticleSlice(const int direction, const Real
 
                 if ( !slice_box.intersects(tile_real_box) ) continue;
 
+                const long np = pti.numParticles();
+                if (np == 0) continue;
+
                 const auto GetPosition = GetParticlePosition(pti);
 
                 auto& attribs = pti.GetAttribs();
@@ -2018,118 +2061,155 @@ void PhysicalParticleContainer::GetParticleSlice(const int direction, const Real
                 Real* const AMREX_RESTRICT
                   uzpold = tmp_particle_data[lev][index][TmpIdx::uzold].dataPtr();
 
-                const long np = pti.numParticles();
-
-                Real uzfrm = -WarpX::gamma_boost*WarpX::beta_boost*PhysConst::c;
-                Real inv_c2 = 1.0/PhysConst::c/PhysConst::c;
+                const Real* const AMREX_RESTRICT zs_old = slice_z_old.dataPtr();
+                const Real* const AMREX_RESTRICT zs_new = slice_z_new.dataPtr();
+                const Real* const AMREX_RESTRICT ts_lab = slice_t_lab.dataPtr();
 
-                // temporary arrays to store copy_flag and copy_index
-                // for particles that cross the z-slice
+                // 1. Single pass over the particles of the tile: flag the
+                // particles that cross at least one of the slices, and
+                // gather their indices.
                 amrex::Gpu::ManagedDeviceVector<int> FlagForPartCopy(np);
                 amrex::Gpu::ManagedDeviceVector<int> IndexForPartCopy(np);
 
                 int* const AMREX_RESTRICT Flag = FlagForPartCopy.dataPtr();
                 int* const AMREX_RESTRICT IndexLocation = IndexForPartCopy.dataPtr();
 
-                //Flag particles that need to be copied if they cross the z_slice
                 amrex::ParallelFor(np,
                 [=] AMREX_GPU_DEVICE(int i)
                 {
                     ParticleReal xp, yp, zp;
                     GetPosition(i, xp, yp, zp);
                     Flag[i] = 0;
-                    if ( (((zp >= z_new) && (zpold[i] <= z_old)) ||
-                          ((zp <= z_new) && (zpold[i] >= z_old))) )
-                    {
-                        Flag[i] = 1;
+                    for (int is = 0; is < nslices; ++is) {
+                        if ( (((zp >= zs_new[is]) && (zpold[i] <= zs_old[is])) ||
+                              ((zp <= zs_new[is]) && (zpold[i] >= zs_old[is]))) )
+                        {
+                            Flag[i] = 1;
+                            break;
+                        }
                     }
                 });
 
-                // exclusive scan to obtain location indices using flag values
-                // These location indices are used to copy data from
-                // src to dst when the copy-flag is set to 1.
                 amrex::Gpu::exclusive_scan(Flag,Flag+np,IndexLocation);
 
-                const int total_partdiag_size = IndexLocation[np-1] + Flag[np-1];
+                const int ncross = IndexLocation[np-1] + Flag[np-1];
+                if (ncross == 0) continue;
+
+                amrex::Gpu::ManagedDeviceVector<int> CrossingParticles(ncross);
+                int* const AMREX_RESTRICT CrossIndex = CrossingParticles.dataPtr();
+                amrex::ParallelFor(np,
+                [=] AMREX_GPU_DEVICE(int i)
+                {
+                    if (Flag[i] == 1) CrossIndex[IndexLocation[i]] = i;
+                });
+
+                // 2. For the crossing particles only: flag the slices that each
+                // particle crosses, and compute the location of the particle
+                // in the data of each slice.
+                amrex::Gpu::ManagedDeviceVector<int> SliceFlag(nslices*ncross);
+                amrex::Gpu::ManagedDeviceVector<int> SliceIndex(nslices*ncross);
+                int* const AMREX_RESTRICT SFlag = SliceFlag.dataPtr();
+                int* const AMREX_RESTRICT SIndex = SliceIndex.dataPtr();
+
+                amrex::ParallelFor(ncross,
+                [=] AMREX_GPU_DEVICE(int j)
+                {
+                    const int i = CrossIndex[j];
+                    ParticleReal xp, yp, zp;
+                    GetPosition(i, xp, yp, zp);
+                    for (int is = 0; is < nslices; ++is) {
+                        SFlag[is*ncross + j] =
+                            ( (((zp >= zs_new[is]) && (zpold[i] <= zs_old[is])) ||
+                               ((zp <= zs_new[is]) && (zpold[i] >= zs_old[is]))) ) ? 1 : 0;
+                    }
+                });
+
+                // Data of each slice: DiagIdx::nattribs pointers per slice
+                amrex::Gpu::ManagedDeviceVector<Real*> SliceData(nslices*DiagIdx::nattribs);
+                for (int is = 0; is < nslices; ++is) {
+                    int* const sflag = SFlag + is*ncross;
+                    int* const sindex = SIndex + is*ncross;
+                    amrex::Gpu::exclusive_scan(sflag,sflag+ncross,sindex);
+                    const int total_partdiag_size = sindex[ncross-1] + sflag[ncross-1];
+
+                    // allocate array size for diagnostic particle array
+                    auto& diag_data = diagnostic_particles[is][lev][index];
+                    diag_data.resize(total_partdiag_size);
+                    for (int comp = 0; comp < DiagIdx::nattribs; ++comp) {
+                        SliceData[is*DiagIdx::nattribs + comp] =
+                            diag_data.GetRealData(comp).data();
+                    }
+                }
+                Real* const* const AMREX_RESTRICT diag_data_ptr = SliceData.dataPtr();
 
-                // allocate array size for diagnostic particle array
-                diagnostic_particles[lev][index].resize(total_partdiag_size);
+                Real uzfrm = -WarpX::gamma_boost*WarpX::beta_boost*PhysConst::c;
+                Real inv_c2 = 1.0/PhysConst::c/PhysConst::c;
 
                 amrex::Real gammaboost = WarpX::gamma_boost;
                 amrex::Real betaboost = WarpX::beta_boost;
                 amrex::Real Phys_c = PhysConst::c;
 
-                Real* const AMREX_RESTRICT diag_wp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::w).data();
-                Real* const AMREX_RESTRICT diag_xp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::x).data();
-                Real* const AMREX_RESTRICT diag_yp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::y).data();
-                Real* const AMREX_RESTRICT diag_zp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::z).data();
-                Real* const AMREX_RESTRICT diag_uxp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::ux).data();
-                Real* const AMREX_RESTRICT diag_uyp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::uy).data();
-                Real* const AMREX_RESTRICT diag_uzp =
-                diagnostic_particles[lev][index].GetRealData(DiagIdx::uz).data();
-
-                // Copy particle data to diagnostic particle array on the GPU
-                //  using flag and index values
-                amrex::ParallelFor(np,
-                [=] AMREX_GPU_DEVICE(int i)
+                // 3. Lorentz-transform the crossing particles and copy them
+                // to the data of each slice that they cross.
+                amrex::ParallelFor(ncross,
+                [=] AMREX_GPU_DEVICE(int j)
                 {
+                    const int i = CrossIndex[j];
                     ParticleReal xp_new, yp_new, zp_new;
                     GetPosition(i, xp_new, yp_new, zp_new);
-                    if (Flag[i] == 1)
-                    {
-                         // Lorentz Transform particles to lab-frame
-                         const Real gamma_new_p = std::sqrt(1.0 + inv_c2*
-                                                  (uxpnew[i]*uxpnew[i]
-                                                 + uypnew[i]*uypnew[i]
-                                                 + uzpnew[i]*uzpnew[i]));
-                         const Real t_new_p = gammaboost*t_boost - uzfrm*zp_new*inv_c2;
-                         const Real z_new_p = gammaboost*(zp_new + betaboost*Phys_c*t_boost);
-                         const Real uz_new_p = gammaboost*uzpnew[i] - gamma_new_p*uzfrm;
-
-                         const Real gamma_old_p = std::sqrt(1.0 + inv_c2*
-                                                  (uxpold[i]*uxpold[i]
-                                                 + uypold[i]*uypold[i]
-                                                 + uzpold[i]*uzpold[i]));
-                         const Real t_old_p = gammaboost*(t_boost - dt)
-                                              - uzfrm*zpold[i]*inv_c2;
-                         const Real z_old_p = gammaboost*(zpold[i]
-                                              + betaboost*Phys_c*(t_boost-dt));
-                         const Real uz_old_p = gammaboost*uzpold[i]
-                                              - gamma_old_p*uzfrm;
-
-                         // interpolate in time to t_lab
-                         const Real weight_old = (t_new_p - t_lab)
-                                               / (t_new_p - t_old_p);
-                         const Real weight_new = (t_lab - t_old_p)
-                                               / (t_new_p - t_old_p);
-
-                         const Real xp = xpold[i]*weight_old + xp_new*weight_new;
-                         const Real yp = ypold[i]*weight_old + yp_new*weight_new;
-                         const Real zp = z_old_p*weight_old  + z_new_p*weight_new;
-
-                         const Real uxp = uxpold[i]*weight_old
-                                        + uxpnew[i]*weight_new;
-                         const Real uyp = uypold[i]*weight_old
-                                        + uypnew[i]*weight_new;
-                         const Real uzp = uz_old_p*weight_old
-                                        + uz_new_p  *weight_new;
-
-                         const int loc = IndexLocation[i];
-                         diag_wp[loc] = wpnew[i];
-                         diag_xp[loc] = xp;
-                         diag_yp[loc] = yp;
-                         diag_zp[loc] = zp;
-                         diag_uxp[loc] = uxp;
-                         diag_uyp[loc] = uyp;
-                         diag_uzp[loc] = uzp;
+
+                    // Lorentz Transform particles to lab-frame
+                    const Real gamma_new_p = std::sqrt(1.0 + inv_c2*
+                                             (uxpnew[i]*uxpnew[i]
+                                            + uypnew[i]*uypnew[i]
+                                            + uzpnew[i]*uzpnew[i]));
+                    const Real t_new_p = gammaboost*t_boost - uzfrm*zp_new*inv_c2;
+                    const Real z_new_p = gammaboost*(zp_new + betaboost*Phys_c*t_boost);
+                    const Real uz_new_p = gammaboost*uzpnew[i] - gamma_new_p*uzfrm;
+
+                    const Real gamma_old_p = std::sqrt(1.0 + inv_c2*
+                                             (uxpold[i]*uxpold[i]
+                                            + uypold[i]*uypold[i]
+                                            + uzpold[i]*uzpold[i]));
+                    const Real t_old_p = gammaboost*(t_boost - dt)
+                                         - uzfrm*zpold[i]*inv_c2;
+                    const Real z_old_p = gammaboost*(zpold[i]
+                                         + betaboost*Phys_c*(t_boost-dt));
+                    const Real uz_old_p = gammaboost*uzpold[i]
+                                         - gamma_old_p*uzfrm;
+
+                    for (int is = 0; is < nslices; ++is) {
+                        if (SFlag[is*ncross + j] == 0) continue;
+
+                        // interpolate in time to t_lab
+                        const Real weight_old = (t_new_p - ts_lab[is])
+                                              / (t_new_p - t_old_p);
+                        const Real weight_new = (ts_lab[is] - t_old_p)
+                                              / (t_new_p - t_old_p);
+
+                        const Real xp = xpold[i]*weight_old + xp_new*weight_new;
+                        const Real yp = ypold[i]*weight_old + yp_new*weight_new;
+                        const Real zp = z_old_p*weight_old  + z_new_p*weight_new;
+
+                        const Real uxp = uxpold[i]*weight_old
+                                       + uxpnew[i]*weight_new;
+                        const Real uyp = uypold[i]*weight_old
+                                       + uypnew[i]*weight_new;
+                        const Real uzp = uz_old_p*weight_old
+                                       + uz_new_p  *weight_new;
+
+                        const int loc = SIndex[is*ncross + j];
+                        Real* const* const diag = diag_data_ptr + is*DiagIdx::nattribs;
+                        diag[DiagIdx::w][loc] = wpnew[i];
+                        diag[DiagIdx::x][loc] = xp;
+                        diag[DiagIdx::y][loc] = yp;
+                        diag[DiagIdx::z][loc] = zp;
+                        diag[DiagIdx::ux][loc] = uxp;
+                        diag[DiagIdx::uy][loc] = uyp;
+                        diag[DiagIdx::uz][loc] = uzp;
                     }
                 });
+                amrex::Gpu::synchronize();
             }
         }
     }
@@ -2143,7 +2223,373 @@ PhysicalParticleContainer::ContinuousInjection(const RealBox& injection_box)
 {
     // Inject plasma on level 0. Paticles will be redistributed.
     const int lev=0;
-    AddPlasma(lev, injection_box);
+
+    const int dir = WarpX::moving_window_dir;
+    const Real dz = Geom(lev).CellSize(dir);
+    const int nlayers = static_cast<int>(std::round(injection_box.length(dir)/dz));
+    if (!m_use_injection_reservoir || nlayers < 1) {
+        AddPlasma(lev, injection_box);
+        return;
+    }
+
+    // Cell layers of the injection box along the moving window direction
+    auto getLayer = [&] (int k) {
+        RealBox layer_box = injection_box;
+        layer_box.setLo(dir, injection_box.lo(dir) + k*dz);
+        layer_box.setHi(dir, injection_box.lo(dir) + (k+1)*dz);
+        return layer_box;
+    };
+
+    // Bounds of the plasma along the moving window direction
+#if (AMREX_SPACEDIM == 3)
+    const Real plasma_lo = (dir == 0) ? plasma_injector->xmin :
+                           (dir == 1) ? plasma_injector->ymin : plasma_injector->zmin;
+    const Real plasma_hi = (dir == 0) ? plasma_injector->xmax :
+                           (dir == 1) ? plasma_injector->ymax : plasma_injector->zmax;
+#else
+    const Real plasma_lo = (dir == 0) ? plasma_injector->xmin : plasma_injector->zmin;
+    const Real plasma_hi = (dir == 0) ? plasma_injector->xmax : plasma_injector->zmax;
+#endif
+
+    for (int k = 0; k < nlayers; ++k) {
+        const RealBox layer_box = getLayer(k);
+        if (layer_box.lo(dir) < plasma_lo || layer_box.hi(dir) > plasma_hi) {
+            // The layer is (partly) outside of the plasma along the moving
+            // window direction: its particles cannot be used in other layers
+            AddPlasma(lev, layer_box);
+        } else if (HasInjectionReservoir(lev, layer_box)) {
+            InjectFromReservoir(lev, layer_box);
+        } else {
+            // First injection inside the plasma in these tiles: the layer is
+            // generated by AddPlasma, and stored in the reservoir
+            BuildInjectionReservoir(lev, layer_box);
+        }
+    }
+}
+
+PhysicalParticleContainer::ReservoirKey
+PhysicalParticleContainer::GetReservoirKey (const Box& tile_box)
+{
+    const int dir = WarpX::moving_window_dir;
+    ReservoirKey key;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        key[2*idim]   = (idim == dir) ? 0 : tile_box.smallEnd(idim);
+        key[2*idim+1] = (idim == dir) ? 0 : tile_box.bigEnd(idim);
+    }
+    return key;
+}
+
+namespace
+{
+    // Whether the tile tile_realbox contains the layer layer_box along the
+    // moving window direction, and overlaps with it in the other directions
+    bool TileOverlapsLayer (const RealBox& tile_realbox, const RealBox& layer_box, int dir)
+    {
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            if (idim == dir) {
+                const Real mid = 0.5*(layer_box.lo(idim) + layer_box.hi(idim));
+                if (mid < tile_realbox.lo(idim) || mid >= tile_realbox.hi(idim)) return false;
+            } else {
+                if (layer_box.lo(idim) >= tile_realbox.hi(idim) ||
+                    layer_box.hi(idim) <= tile_realbox.lo(idim)) return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool
+PhysicalParticleContainer::HasInjectionReservoir (int lev, const RealBox& layer_box)
+{
+    const int dir = WarpX::moving_window_dir;
+    MFItInfo info;
+    if (do_tiling && Gpu::notInLaunchRegion()) {
+        info.EnableTiling(tile_size);
+    }
+    for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi)
+    {
+        const Box& tile_box = mfi.tilebox();
+        if (!TileOverlapsLayer(WarpX::getRealBox(tile_box, lev), layer_box, dir)) continue;
+        if (m_injection_reservoir.count(GetReservoirKey(tile_box)) == 0) return false;
+    }
+    return true;
+}
+
+void
+PhysicalParticleContainer::BuildInjectionReservoir (int lev, const RealBox& layer_box)
+{
+    BL_PROFILE("PhysicalParticleContainer::BuildInjectionReservoir");
+
+    const int dir = WarpX::moving_window_dir;
+    MFItInfo info;
+    if (do_tiling && Gpu::notInLaunchRegion()) {
+        info.EnableTiling(tile_size);
+    }
+
+    // Number of particles in each tile before the injection
+    defineAllParticleTiles();
+    std::map<std::pair<int,int>, long> old_sizes;
+    for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi) {
+        const auto index = std::make_pair(mfi.index(), mfi.LocalTileIndex());
+        old_sizes[index] = GetParticles(lev)[index].numParticles();
+    }
+
+    AddPlasma(lev, layer_box);
+
+    // Store the new particles of each tile that overlaps the layer
+    const Real layer_lo = layer_box.lo(dir);
+    for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi)
+    {
+        const Box& tile_box = mfi.tilebox();
+        if (!TileOverlapsLayer(WarpX::getRealBox(tile_box, lev), layer_box, dir)) continue;
+
+        const auto index = std::make_pair(mfi.index(), mfi.LocalTileIndex());
+        auto& particle_tile = GetParticles(lev)[index];
+        const long old_size = old_sizes[index];
+        const long np_new = particle_tile.numParticles() - old_size;
+        const ParticleType* const AMREX_RESTRICT pp =
+            particle_tile.GetArrayOfStructs()().data() + old_size;
+
+        // AddPlasma can leave invalid slots (negative id): only the valid
+        // particles are stored, at the index given by a scan of the flags
+        Gpu::DeviceVector<int> valid(np_new);
+        Gpu::DeviceVector<int> dst_index(np_new);
+        int* const AMREX_RESTRICT p_valid = valid.dataPtr();
+        int* const AMREX_RESTRICT p_dst_index = dst_index.dataPtr();
+        amrex::ParallelFor(np_new, [=] AMREX_GPU_DEVICE (long i) noexcept
+        {
+            p_valid[i] = (pp[i].id() >= 0) ? 1 : 0;
+        });
+        long np = 0;
+        if (np_new > 0) {
+            Gpu::exclusive_scan(p_valid, p_valid+np_new, p_dst_index);
+            int last_valid, last_index;
+            Gpu::copyAsync(Gpu::deviceToHost, p_valid+np_new-1, p_valid+np_new, &last_valid);
+            Gpu::copyAsync(Gpu::deviceToHost, p_dst_index+np_new-1, p_dst_index+np_new, &last_index);
+            Gpu::streamSynchronize();
+            np = last_valid + last_index;
+        }
+
+        InjectionReservoirSlab& slab = m_injection_reservoir[GetReservoirKey(tile_box)];
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            slab.pos[idim].resize(np);
+        }
+        slab.w.resize(np);
+        slab.ux.resize(np);
+        slab.uy.resize(np);
+        slab.uz.resize(np);
+#ifdef WARPX_DIM_RZ
+        slab.theta.resize(np);
+        ParticleReal* const AMREX_RESTRICT theta_s = slab.theta.dataPtr();
+        const ParticleReal* const AMREX_RESTRICT theta_p =
+            particle_tile.GetStructOfArrays().GetRealData(PIdx::theta).data() + old_size;
+#endif
+        if (np == 0) continue;
+
+        auto& soa = particle_tile.GetStructOfArrays();
+        const ParticleReal* const AMREX_RESTRICT wp = soa.GetRealData(PIdx::w).data() + old_size;
+        const ParticleReal* const AMREX_RESTRICT uxp = soa.GetRealData(PIdx::ux).data() + old_size;
+        const ParticleReal* const AMREX_RESTRICT uyp = soa.GetRealData(PIdx::uy).data() + old_size;
+        const ParticleReal* const AMREX_RESTRICT uzp = soa.GetRealData(PIdx::uz).data() + old_size;
+        GpuArray<ParticleReal*,AMREX_SPACEDIM> pos_s;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            pos_s[idim] = slab.pos[idim].dataPtr();
+        }
+        ParticleReal* const AMREX_RESTRICT w_s = slab.w.dataPtr();
+        ParticleReal* const AMREX_RESTRICT ux_s = slab.ux.dataPtr();
+        ParticleReal* const AMREX_RESTRICT uy_s = slab.uy.dataPtr();
+        ParticleReal* const AMREX_RESTRICT uz_s = slab.uz.dataPtr();
+
+        amrex::ParallelFor(np_new, [=] AMREX_GPU_DEVICE (long i) noexcept
+        {
+            if (!p_valid[i]) return;
+            const int j = p_dst_index[i];
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                pos_s[idim][j] = pp[i].pos(idim) - ((idim == dir) ? layer_lo : 0.);
+            }
+            w_s[j] = wp[i];
+            ux_s[j] = uxp[i];
+            uy_s[j] = uyp[i];
+            uz_s[j] = uzp[i];
+#ifdef WARPX_DIM_RZ
+            theta_s[j] = theta_p[i];
+#endif
+        });
+        // The scan arrays are freed at the end of the iteration
+        Gpu::synchronize();
+    }
+    Gpu::synchronize();
+}
+
+void
+PhysicalParticleContainer::InjectFromReservoir (int lev, const RealBox& layer_box)
+{
+    BL_PROFILE("PhysicalParticleContainer::InjectFromReservoir");
+
+    const int dir = WarpX::moving_window_dir;
+    const Real layer_lo = layer_box.lo(dir);
+
+    InjectorPosition* inj_pos = plasma_injector->getInjectorPosition();
+    InjectorMomentum* inj_mom = plasma_injector->getInjectorMomentum();
+    // The momenta are drawn again, unless they are the same for all particles
+    const bool redraw_momentum = !inj_mom->isConstant();
+
+    bool loc_do_field_ionization = do_field_ionization;
+    int loc_ionization_initial_level = ionization_initial_level;
+
+#ifdef WARPX_QED
+    bool loc_has_quantum_sync = has_quantum_sync();
+    bool loc_has_breit_wheeler = has_breit_wheeler();
+    QuantumSynchrotronGetOpticalDepth quantum_sync_get_opt;
+    BreitWheelerGetOpticalDepth breit_wheeler_get_opt;
+    if(loc_has_quantum_sync){
+        quantum_sync_get_opt =
+            m_shr_p_qs_engine->build_optical_depth_functor();
+    }
+    if(loc_has_breit_wheeler){
+        breit_wheeler_get_opt =
+            m_shr_p_bw_engine->build_optical_depth_functor();
+    }
+    const bool loc_use_counter_rng = WarpX::use_counter_rng;
+    const WarpXRandom::CounterRNG optical_depth_rng(WarpX::random_seed,
+        WarpXRandom::Stream::OpticalDepth, species_id, WarpX::GetInstance().getistep(0));
+#endif
+
+    defineAllParticleTiles();
+
+    // Next particle id: each tile reserves the ids of its new particles
+    // with an atomic fetch-add, and NextID is updated after the loop.
+    int next_pid = ParticleType::NextID();
+    const int cpuid = ParallelDescriptor::MyProc();
+
+    MFItInfo info;
+    if (do_tiling && Gpu::notInLaunchRegion()) {
+        info.EnableTiling(tile_size);
+    }
+#ifdef _OPENMP
+    info.SetDynamic(true);
+#pragma omp parallel if (not WarpX::serialize_ics)
+#endif
+    for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi)
+    {
+        const Box& tile_box = mfi.tilebox();
+        if (!TileOverlapsLayer(WarpX::getRealBox(tile_box, lev), layer_box, dir)) continue;
+
+        const InjectionReservoirSlab& slab = m_injection_reservoir.at(GetReservoirKey(tile_box));
+        const long np = slab.w.size();
+        if (np == 0) continue;
+
+        int pid;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+        { pid = next_pid; next_pid += np; }
+
+        const int grid_id = mfi.index();
+        const int tile_id = mfi.LocalTileIndex();
+        auto& particle_tile = GetParticles(lev)[std::make_pair(grid_id,tile_id)];
+        if ( (NumRuntimeRealComps()>0) || (NumRuntimeIntComps()>0) ) {
+            DefineAndReturnParticleTile(lev, grid_id, tile_id);
+        }
+        auto old_size = particle_tile.GetArrayOfStructs().size();
+        particle_tile.resize(old_size + np);
+
+        ParticleType* pp = particle_tile.GetArrayOfStructs()().data() + old_size;
+        auto& soa = particle_tile.GetStructOfArrays();
+        GpuArray<ParticleReal*,PIdx::nattribs> pa;
+        for (int ia = 0; ia < PIdx::nattribs; ++ia) {
+            pa[ia] = soa.GetRealData(ia).data() + old_size;
+        }
+        int* pi;
+        if (do_field_ionization) {
+            pi = soa.GetIntData(particle_icomps["ionization_level"]).data() + old_size;
+        }
+#ifdef WARPX_QED
+        amrex::Real* p_tau;
+        if(loc_has_quantum_sync || loc_has_breit_wheeler){
+            p_tau = soa.GetRealData(particle_comps["tau"]).data() + old_size;
+        }
+#endif
+
+        GpuArray<const ParticleReal*,AMREX_SPACEDIM> pos_s;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            pos_s[idim] = slab.pos[idim].dataPtr();
+        }
+        const ParticleReal* const AMREX_RESTRICT w_s = slab.w.dataPtr();
+        const ParticleReal* const AMREX_RESTRICT ux_s = slab.ux.dataPtr();
+        const ParticleReal* const AMREX_RESTRICT uy_s = slab.uy.dataPtr();
+        const ParticleReal* const AMREX_RESTRICT uz_s = slab.uz.dataPtr();
+#ifdef WARPX_DIM_RZ
+        const ParticleReal* const AMREX_RESTRICT theta_s = slab.theta.dataPtr();
+#endif
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (long i) noexcept
+        {
+            ParticleType& p = pp[i];
+            p.id() = pid+i;
+            p.cpu() = cpuid;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                p.pos(idim) = pos_s[idim][i] + ((idim == dir) ? layer_lo : 0.);
+            }
+#if (AMREX_SPACEDIM == 3)
+            const Real xb = p.pos(0);
+            const Real yb = p.pos(1);
+            const Real z = p.pos(2);
+#else
+            const Real xb = p.pos(0);
+            const Real yb = 0.;
+            const Real z = p.pos(1);
+#endif
+            // The bounds of the plasma along the moving window direction
+            // are checked again
+            if (!inj_pos->insideBounds(xb, yb, z)) {
+                p.id() = -1;
+                return;
+            }
+
+            pa[PIdx::w][i] = w_s[i];
+#ifdef WARPX_DIM_RZ
+            pa[PIdx::theta][i] = theta_s[i];
+#endif
+            if (redraw_momentum) {
+#ifdef WARPX_DIM_RZ
+                const Real x = xb*std::cos(theta_s[i]);
+                const Real y = xb*std::sin(theta_s[i]);
+#else
+                const Real x = xb;
+                const Real y = yb;
+#endif
+                const XDim3 u = inj_mom->getMomentum(x, y, z);
+                pa[PIdx::ux][i] = u.x*PhysConst::c;
+                pa[PIdx::uy][i] = u.y*PhysConst::c;
+                pa[PIdx::uz][i] = u.z*PhysConst::c;
+            } else {
+                pa[PIdx::ux][i] = ux_s[i];
+                pa[PIdx::uy][i] = uy_s[i];
+                pa[PIdx::uz][i] = uz_s[i];
+            }
+
+            if (loc_do_field_ionization) {
+                pi[i] = loc_ionization_initial_level;
+            }
+
+#ifdef WARPX_QED
+            if(loc_has_quantum_sync){
+                p_tau[i] = loc_use_counter_rng ?
+                    quantum_sync_get_opt(optical_depth_rng.uniform(pid+i, cpuid, 0)) :
+                    quantum_sync_get_opt();
+            }
+
+            if(loc_has_breit_wheeler){
+                p_tau[i] = loc_use_counter_rng ?
+                    breit_wheeler_get_opt(optical_depth_rng.uniform(pid+i, cpuid, 0)) :
+                    breit_wheeler_get_opt();
+            }
+#endif
+        });
+    }
+
+    ParticleType::NextID(next_pid);
 }
 
 /* \brief Gather fields from FArrayBox exfab, eyfab, ezfab, bxfab, byfab,
@@ -2281,6 +2727,9 @@ void PhysicalParticleContainer::InitIonizationModule ()
         charge = PhysConst::q_e;
     }
     pp.query("ionization_initial_level", ionization_initial_level);
+    pp.query("ionization_ndt", ionization_ndt);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(ionization_ndt >= 1,
+        "ionization_ndt must be >= 1");
     pp.get("ionization_product_species", ionization_product_name);
     pp.get("physical_element", physical_element);
     // Add runtime integer component for ionization level
@@ -2303,7 +2752,9 @@ void PhysicalParticleContainer::InitIonizationModule ()
     Real UH = table_ionization_energies[0];
     Real l_eff = std::sqrt(UH/ionization_energies[0]) - 1.;
 
-    const Real dt = WarpX::GetInstance().getdt(0);
+    // When ionization is sub-cycled, the probability is accumulated
+    // over the ionization_ndt steps between two evaluations
+    const Real dt = ionization_ndt * WarpX::GetInstance().getdt(0);
 
     adk_power.resize(ion_atomic_number);
     adk_prefactor.resize(ion_atomic_number);
@@ -2329,7 +2780,84 @@ PhysicalParticleContainer::getIonizationFunc ()
                                 adk_exp_prefactor.dataPtr(),
                                 adk_power.dataPtr(),
                                 particle_icomps["ionization_level"],
-                                ion_atomic_number};
+                                ion_atomic_number,
+                                WarpX::use_counter_rng,
+                                WarpXRandom::CounterRNG(
+                                    WarpX::random_seed,
+                                    WarpXRandom::Stream::Ionization, species_id,
+                                    WarpX::GetInstance().getistep(0))};
+}
+
+IonizableFunc
+PhysicalParticleContainer::getIonizableFunc ()
+{
+    return IonizableFunc{particle_icomps["ionization_level"],
+                         ion_atomic_number};
+}
+
+void
+PhysicalParticleContainer::Resample (int lev)
+{
+    BL_PROFILE("PPC::Resample");
+
+    const int max_ppc = resampling_max_ppc;
+    const int target_ppc = resampling_target_ppc;
+    const int n_bins_max = resampling_n_momentum_bins;
+    const bool massless = AmIAPhoton();
+    const bool use_counter_rng = WarpX::use_counter_rng;
+    const WarpXRandom::CounterRNG rng(WarpX::random_seed,
+        WarpXRandom::Stream::Resampling, species_id,
+        WarpX::GetInstance().getistep(0));
+
+    // Enable tiling (same tiles as the collisions, so that the
+    // cell index of each tile can be shared)
+    MFItInfo info;
+    if (Gpu::notInLaunchRegion()) info.EnableTiling(tile_size);
+#ifdef _OPENMP
+    info.SetDynamic(true);
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi)
+    {
+        auto& ptile = ParticlesAt(lev, mfi);
+        if (ptile.numParticles() == 0) continue;
+
+        // Find the particles that are in each cell of this tile
+        auto& bins = GetCellBins(lev, mfi);
+        auto* const AMREX_RESTRICT indices = bins.permutationPtr();
+        const auto* const AMREX_RESTRICT cell_offsets = bins.offsetsPtr();
+
+        ParticleType* const AMREX_RESTRICT particles = ptile.GetArrayOfStructs()().data();
+        auto& soa = ptile.GetStructOfArrays();
+        ParticleReal* const AMREX_RESTRICT w = soa.GetRealData(PIdx::w).data();
+        ParticleReal* const AMREX_RESTRICT ux = soa.GetRealData(PIdx::ux).data();
+        ParticleReal* const AMREX_RESTRICT uy = soa.GetRealData(PIdx::uy).data();
+        ParticleReal* const AMREX_RESTRICT uz = soa.GetRealData(PIdx::uz).data();
+        // Particles with different ionization levels are not merged
+        const int* const AMREX_RESTRICT ion_lev = do_field_ionization ?
+            soa.GetIntData(particle_icomps["ionization_level"]).data() : nullptr;
+        const int n_ion_lev = do_field_ionization ? ion_atomic_number + 1 : 1;
+
+        // Scratch arrays used to sort the particles of each cell by bin
+        const auto np = ptile.numParticles();
+        Gpu::DeviceVector<DenseBins<ParticleType>::index_type> sort_buffer(np);
+        Gpu::DeviceVector<int> keys(np);
+        auto* const AMREX_RESTRICT p_sort_buffer = sort_buffer.dataPtr();
+        int* const AMREX_RESTRICT p_keys = keys.dataPtr();
+
+        amrex::ParallelFor( bins.numBins(),
+            [=] AMREX_GPU_DEVICE (int i_cell) noexcept
+            {
+                MergeParticlesInCell(
+                    cell_offsets[i_cell], cell_offsets[i_cell+1], indices,
+                    p_sort_buffer, p_keys,
+                    particles, w, ux, uy, uz, ion_lev, n_ion_lev,
+                    max_ppc, target_ppc, n_bins_max,
+                    massless, use_counter_rng, rng );
+            });
+        // The scratch arrays are freed at the end of the iteration
+        Gpu::synchronize();
+    }
 }
 
 //This function return true if the PhysicalParticleContainer contains electrons
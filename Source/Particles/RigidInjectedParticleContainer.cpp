@@ -25,6 +25,8 @@
 #include <UpdateMomentumHigueraCary.H>
 #include <GetAndSetPosition.H>
 
+#include <AMReX_Reduce.H>
+
 using namespace amrex;
 
 RigidInjectedParticleContainer::RigidInjectedParticleContainer (AmrCore* amr_core, int ispecies,
@@ -240,6 +242,35 @@ RigidInjectedParticleContainer::PushPX (WarpXParIter& pti, Real dt, DtType a_dt_
     ParticleReal* const AMREX_RESTRICT Byp = attribs[PIdx::By].dataPtr();
     ParticleReal* const AMREX_RESTRICT Bzp = attribs[PIdx::Bz].dataPtr();
 
+    if (all_before_plane_lev)
+    {
+        // None of the particles crosses the plane: they are only advanced
+        // rigidly (with the same result as undoing the push below), so the
+        // momentum push and the copies are skipped.
+        if (WarpX::do_back_transformed_diagnostics && do_back_transformed_diagnostics && (a_dt_type!=DtType::SecondHalf))
+        {
+            copy_attribs(pti);
+        }
+
+        const Real vz_ave_boosted = vzbeam_ave_boosted;
+        const bool rigid = rigid_advance;
+        const Real inv_csq = 1./(PhysConst::c*PhysConst::c);
+        amrex::ParallelFor( pti.numParticles(),
+                            [=] AMREX_GPU_DEVICE (long i) {
+                                ParticleReal xp, yp, zp;
+                                GetPosition(i, xp, yp, zp);
+                                if (rigid) {
+                                    zp += dt*vz_ave_boosted;
+                                }
+                                else {
+                                    const Real gi = 1./std::sqrt(1. + (ux[i]*ux[i] + uy[i]*uy[i] + uz[i]*uz[i])*inv_csq);
+                                    zp += dt*uz[i]*gi;
+                                }
+                                SetPosition(i, xp, yp, zp);
+                            });
+        return;
+    }
+
     if (!done_injecting_lev)
     {
         // If the old values are not already saved, create copies here.
@@ -356,13 +387,37 @@ RigidInjectedParticleContainer::Evolve (int lev,
 
     // Set the done injecting flag whan the inject plane moves out of the
     // simulation domain.
-    // It is much easier to do this check, rather than checking if all of the
-    // particles have crossed the inject plane.
     const Real* plo = Geom(lev).ProbLo();
     const Real* phi = Geom(lev).ProbHi();
     const int zdir = AMREX_SPACEDIM-1;
-    done_injecting[lev] = ((zinject_plane_levels[lev] < plo[zdir] && WarpX::moving_window_v + WarpX::beta_boost*PhysConst::c >= 0.) ||
+    done_injecting[lev] = done_injecting[lev] ||
+                          ((zinject_plane_levels[lev] < plo[zdir] && WarpX::moving_window_v + WarpX::beta_boost*PhysConst::c >= 0.) ||
                            (zinject_plane_levels[lev] > phi[zdir] && WarpX::moving_window_v + WarpX::beta_boost*PhysConst::c <= 0.));
+
+    // Otherwise, use the extent in z of the particles (of all levels and
+    // ranks, since particles can move to another level): since a particle
+    // moves by less than c*dt, it is known before the push whether all the
+    // particles are on the same side of the plane.
+    all_before_plane_lev = false;
+    if (!done_injecting[lev]) {
+        Real zmin, zmax;
+        ParticleZExtent(zmin, zmax);
+        const Real max_dz = PhysConst::c*dt;
+        if (zmin <= zmax) {
+            // Particles cross the plane when z > zinject_plane_lev; the
+            // fields of the particles are scaled (in PushPX) when
+            // z < zinject_plane_lev_previous
+            if (zmin > std::max(zinject_plane_lev_previous, zinject_plane_lev + max_dz) &&
+                vzbeam_ave_boosted + WarpX::beta_boost*PhysConst::c >= 0.) {
+                // All the particles have crossed the plane: from now on,
+                // they are evolved as regular particles.
+                done_injecting[lev] = 1;
+            } else if (zmax + max_dz <= zinject_plane_lev) {
+                // None of the particles crosses the plane during this step
+                all_before_plane_lev = true;
+            }
+        }
+    }
     done_injecting_lev = done_injecting[lev];
 
     PhysicalParticleContainer::Evolve (lev,
@@ -376,6 +431,38 @@ RigidInjectedParticleContainer::Evolve (int lev,
                                        t, dt, a_dt_type);
 }
 
+void
+RigidInjectedParticleContainer::ParticleZExtent (Real& zmin, Real& zmax)
+{
+    BL_PROFILE("RigidInjectedParticleContainer::ParticleZExtent");
+
+    ReduceOps<ReduceOpMin, ReduceOpMax> reduce_op;
+    ReduceData<Real, Real> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+
+    for (int lev = 0; lev <= finestLevel(); ++lev)
+    {
+        for (WarpXParIter pti(*this, lev); pti.isValid(); ++pti)
+        {
+            const auto GetPosition = GetParticlePosition(pti);
+            reduce_op.eval(pti.numParticles(), reduce_data,
+                           [=] AMREX_GPU_DEVICE (long i) -> ReduceTuple
+                           {
+                               ParticleReal xp, yp, zp;
+                               GetPosition(i, xp, yp, zp);
+                               return {zp, zp};
+                           });
+        }
+    }
+
+    ReduceTuple hv = reduce_data.value();
+    // Reduce min(z) and min(-z) in a single call
+    Real z_extent[2] = {amrex::get<0>(hv), -amrex::get<1>(hv)};
+    ParallelDescriptor::ReduceRealMin(z_extent, 2);
+    zmin = z_extent[0];
+    zmax = -z_extent[1];
+}
+
 void
 RigidInjectedParticleContainer::PushP (int lev, Real dt,
                                        const MultiFab& Ex, const MultiFab& Ey, const MultiFab& Ez,
@@ -747,6 +747,85 @@ WarpXParticleContainer::PushX (int lev, amrex::Real dt)
     }
 }
 
+DenseBins<WarpXParticleContainer::ParticleType>&
+WarpXParticleContainer::GetCellBins (int lev, const MFIter& mfi)
+{
+    const auto& ptile = ParticlesAt(lev, mfi);
+    const long np = ptile.numParticles();
+    const Box cbx = mfi.tilebox(IntVect::TheZeroVector()); //Cell-centered box
+
+    CellBins* entry;
+#ifdef _OPENMP
+#pragma omp critical (warpx_cell_bins)
+#endif
+    {
+        if (static_cast<int>(m_cell_bins.size()) <= lev) m_cell_bins.resize(lev+1);
+        entry = &m_cell_bins[lev][std::make_pair(mfi.index(), mfi.LocalTileIndex())];
+    }
+
+    if (entry->valid && entry->np == np && entry->box == cbx) return entry->bins;
+
+    // Find the particles that are in each cell of the tile.
+    // Note that this does *not* rearrange particle arrays
+    ParticleType const* particle_ptr = ptile.GetArrayOfStructs()().data();
+    const auto lo = lbound(cbx);
+    const auto dxi = Geom(lev).InvCellSizeArray();
+    const auto plo = Geom(lev).ProbLoArray();
+    entry->bins.build(np, particle_ptr, cbx,
+        // Pass lambda function that returns the cell index
+        [=] AMREX_GPU_HOST_DEVICE (const ParticleType& p) noexcept -> IntVect
+        {
+            return IntVect(AMREX_D_DECL((p.pos(0)-plo[0])*dxi[0] - lo.x,
+                                        (p.pos(1)-plo[1])*dxi[1] - lo.y,
+                                        (p.pos(2)-plo[2])*dxi[2] - lo.z));
+        });
+    entry->box = cbx;
+    entry->np = np;
+    entry->valid = true;
+    return entry->bins;
+}
+
+void
+WarpXParticleContainer::InvalidateCellBins ()
+{
+    for (auto& bins_lev : m_cell_bins) {
+        for (auto& kv : bins_lev) kv.second.valid = false;
+    }
+}
+
+void
+WarpXParticleContainer::SortParticlesByCell ()
+{
+    BL_PROFILE("WarpXParticleContainer::SortParticlesByCell()");
+
+    MFItInfo info;
+    if (do_tiling && Gpu::notInLaunchRegion()) info.EnableTiling(tile_size);
+#ifdef _OPENMP
+    info.SetDynamic(true);
+#endif
+
+    for (int lev = 0; lev <= finestLevel(); ++lev)
+    {
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi = MakeMFIter(lev, info); mfi.isValid(); ++mfi)
+        {
+            auto& bins = GetCellBins(lev, mfi);
+            ReorderParticles(lev, mfi, bins.permutationPtr());
+
+            // The particles are now ordered by cell: the index remains
+            // valid, with the identity permutation
+            auto* const AMREX_RESTRICT permutation = bins.permutationPtr();
+            amrex::ParallelFor(bins.numItems(),
+                [=] AMREX_GPU_DEVICE (int i) noexcept
+                {
+                    permutation[i] = i;
+                });
+        }
+    }
+}
+
 // When using runtime components, AMReX requires to touch all tiles
 // in serial and create particles tiles with runtime components if
 // they do not exist (or if they were defined by default, i.e.,
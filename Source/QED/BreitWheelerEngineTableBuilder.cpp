@@ -5,6 +5,9 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "BreitWheelerEngineTableBuilder.H"
+#include "QedTableParserHelperFunctions.H"
+
+#include <AMReX_ParallelDescriptor.H>
 
 //Include the full Breit Wheeler engine with table generation support
 //(after some consistency tests). This requires to have a recent version
@@ -32,33 +35,83 @@ BreitWheelerEngineTableBuilder::compute_table
     (PicsarBreitWheelerCtrl ctrl,
      BreitWheelerEngineInnards& innards) const
 {
-    PicsarBreitWheelerEngine bw_engine(
-        std::move(QedUtils::DummyStruct()), 1.0, ctrl);
+    using namespace amrex;
+
+    //The rows of the two sub-tables (i.e. the values of chi) are
+    //independent: each sub-table is computed by slices of chi, distributed
+    //over the MPI ranks, and gathered on all the ranks. A slice is computed
+    //as a table whose chi axis is the corresponding part of the full chi axis.
+    Vector<Real> TTfunc_coords, TTfunc_data, unused_coords;
+    QedUtils::compute_table_by_slices(
+        ctrl.chi_phot_tdndt_how_many, 1, false,
+        [&](int first_row, int how_many,
+            Vector<Real>& coords, Vector<Real>& data, Vector<Real>&){
+            auto slice_ctrl = ctrl;
+            slice_ctrl.chi_phot_tdndt_min = QedUtils::log_spaced_coord(
+                ctrl.chi_phot_tdndt_min, ctrl.chi_phot_tdndt_max,
+                ctrl.chi_phot_tdndt_how_many, first_row);
+            slice_ctrl.chi_phot_tdndt_max = QedUtils::log_spaced_coord(
+                ctrl.chi_phot_tdndt_min, ctrl.chi_phot_tdndt_max,
+                ctrl.chi_phot_tdndt_how_many, first_row + how_many - 1);
+            slice_ctrl.chi_phot_tdndt_how_many = how_many;
+
+            PicsarBreitWheelerEngine bw_engine(
+                std::move(QedUtils::DummyStruct()), 1.0, slice_ctrl);
+            bw_engine.compute_dN_dt_lookup_table();
+            auto bw_innards_picsar = bw_engine.export_innards();
+
+            coords.assign(bw_innards_picsar.TTfunc_table_coords_ptr,
+                bw_innards_picsar.TTfunc_table_coords_ptr +
+                bw_innards_picsar.TTfunc_table_coords_how_many);
+            data.assign(bw_innards_picsar.TTfunc_table_data_ptr,
+                bw_innards_picsar.TTfunc_table_data_ptr +
+                bw_innards_picsar.TTfunc_table_data_how_many);
+        },
+        TTfunc_coords, TTfunc_data, unused_coords);
+
+    Vector<Real> cum_distrib_coords_1, cum_distrib_coords_2, cum_distrib_data;
+    QedUtils::compute_table_by_slices(
+        ctrl.chi_phot_tpair_how_many, ctrl.chi_frac_tpair_how_many, true,
+        [&](int first_row, int how_many,
+            Vector<Real>& coords, Vector<Real>& data, Vector<Real>& coords_2){
+            auto slice_ctrl = ctrl;
+            slice_ctrl.chi_phot_tpair_min = QedUtils::log_spaced_coord(
+                ctrl.chi_phot_tpair_min, ctrl.chi_phot_tpair_max,
+                ctrl.chi_phot_tpair_how_many, first_row);
+            slice_ctrl.chi_phot_tpair_max = QedUtils::log_spaced_coord(
+                ctrl.chi_phot_tpair_min, ctrl.chi_phot_tpair_max,
+                ctrl.chi_phot_tpair_how_many, first_row + how_many - 1);
+            slice_ctrl.chi_phot_tpair_how_many = how_many;
 
-    bw_engine.compute_dN_dt_lookup_table();
-    bw_engine.compute_cumulative_pair_table();
+            PicsarBreitWheelerEngine bw_engine(
+                std::move(QedUtils::DummyStruct()), 1.0, slice_ctrl);
+            bw_engine.compute_cumulative_pair_table();
+            auto bw_innards_picsar = bw_engine.export_innards();
 
-    auto bw_innards_picsar = bw_engine.export_innards();
+            coords.assign(
+                bw_innards_picsar.cum_distrib_table_coords_1_ptr,
+                bw_innards_picsar.cum_distrib_table_coords_1_ptr +
+                bw_innards_picsar.cum_distrib_table_coords_1_how_many);
+            coords_2.assign(
+                bw_innards_picsar.cum_distrib_table_coords_2_ptr,
+                bw_innards_picsar.cum_distrib_table_coords_2_ptr +
+                bw_innards_picsar.cum_distrib_table_coords_2_how_many);
+            data.assign(
+                bw_innards_picsar.cum_distrib_table_data_ptr,
+                bw_innards_picsar.cum_distrib_table_data_ptr +
+                bw_innards_picsar.cum_distrib_table_data_how_many);
+        },
+        cum_distrib_coords_1, cum_distrib_data, cum_distrib_coords_2);
 
     //Copy data in a GPU-friendly data-structure
-    innards.ctrl = bw_innards_picsar.bw_ctrl;
-    innards.TTfunc_coords.assign(bw_innards_picsar.TTfunc_table_coords_ptr,
-        bw_innards_picsar.TTfunc_table_coords_ptr +
-        bw_innards_picsar.TTfunc_table_coords_how_many);
-    innards.TTfunc_data.assign(bw_innards_picsar.TTfunc_table_data_ptr,
-        bw_innards_picsar.TTfunc_table_data_ptr +
-        bw_innards_picsar.TTfunc_table_data_how_many);
+    innards.ctrl = ctrl;
+    innards.TTfunc_coords.assign(TTfunc_coords.begin(), TTfunc_coords.end());
+    innards.TTfunc_data.assign(TTfunc_data.begin(), TTfunc_data.end());
     innards.cum_distrib_coords_1.assign(
-        bw_innards_picsar.cum_distrib_table_coords_1_ptr,
-        bw_innards_picsar.cum_distrib_table_coords_1_ptr +
-        bw_innards_picsar.cum_distrib_table_coords_1_how_many);
+        cum_distrib_coords_1.begin(), cum_distrib_coords_1.end());
     innards.cum_distrib_coords_2.assign(
-        bw_innards_picsar.cum_distrib_table_coords_2_ptr,
-        bw_innards_picsar.cum_distrib_table_coords_2_ptr +
-        bw_innards_picsar.cum_distrib_table_coords_2_how_many);
+        cum_distrib_coords_2.begin(), cum_distrib_coords_2.end());
     innards.cum_distrib_data.assign(
-        bw_innards_picsar.cum_distrib_table_data_ptr,
-        bw_innards_picsar.cum_distrib_table_data_ptr +
-        bw_innards_picsar.cum_distrib_table_data_how_many);
+        cum_distrib_data.begin(), cum_distrib_data.end());
     //____
 }
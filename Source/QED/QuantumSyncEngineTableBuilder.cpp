@@ -5,6 +5,9 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "QuantumSyncEngineTableBuilder.H"
+#include "QedTableParserHelperFunctions.H"
+
+#include <AMReX_ParallelDescriptor.H>
 
 //Include the full Quantum Synchrotron engine with table generation support
 //(after some consistency tests). This requires to have a recent version
@@ -32,33 +35,83 @@ QuantumSynchrotronEngineTableBuilder::compute_table
     (PicsarQuantumSynchrotronCtrl ctrl,
      QuantumSynchrotronEngineInnards& innards) const
 {
-    PicsarQuantumSynchrotronEngine qs_engine(
-        std::move(QedUtils::DummyStruct()), 1.0, ctrl);
+    using namespace amrex;
+
+    //The rows of the two sub-tables (i.e. the values of chi) are
+    //independent: each sub-table is computed by slices of chi, distributed
+    //over the MPI ranks, and gathered on all the ranks. A slice is computed
+    //as a table whose chi axis is the corresponding part of the full chi axis.
+    Vector<Real> KKfunc_coords, KKfunc_data, unused_coords;
+    QedUtils::compute_table_by_slices(
+        ctrl.chi_part_tdndt_how_many, 1, false,
+        [&](int first_row, int how_many,
+            Vector<Real>& coords, Vector<Real>& data, Vector<Real>&){
+            auto slice_ctrl = ctrl;
+            slice_ctrl.chi_part_tdndt_min = QedUtils::log_spaced_coord(
+                ctrl.chi_part_tdndt_min, ctrl.chi_part_tdndt_max,
+                ctrl.chi_part_tdndt_how_many, first_row);
+            slice_ctrl.chi_part_tdndt_max = QedUtils::log_spaced_coord(
+                ctrl.chi_part_tdndt_min, ctrl.chi_part_tdndt_max,
+                ctrl.chi_part_tdndt_how_many, first_row + how_many - 1);
+            slice_ctrl.chi_part_tdndt_how_many = how_many;
+
+            PicsarQuantumSynchrotronEngine qs_engine(
+                std::move(QedUtils::DummyStruct()), 1.0, slice_ctrl);
+            qs_engine.compute_dN_dt_lookup_table();
+            auto qs_innards_picsar = qs_engine.export_innards();
+
+            coords.assign(qs_innards_picsar.KKfunc_table_coords_ptr,
+                qs_innards_picsar.KKfunc_table_coords_ptr +
+                qs_innards_picsar.KKfunc_table_coords_how_many);
+            data.assign(qs_innards_picsar.KKfunc_table_data_ptr,
+                qs_innards_picsar.KKfunc_table_data_ptr +
+                qs_innards_picsar.KKfunc_table_data_how_many);
+        },
+        KKfunc_coords, KKfunc_data, unused_coords);
+
+    Vector<Real> cum_distrib_coords_1, cum_distrib_coords_2, cum_distrib_data;
+    QedUtils::compute_table_by_slices(
+        ctrl.chi_part_tem_how_many, ctrl.prob_tem_how_many, true,
+        [&](int first_row, int how_many,
+            Vector<Real>& coords, Vector<Real>& data, Vector<Real>& coords_2){
+            auto slice_ctrl = ctrl;
+            slice_ctrl.chi_part_tem_min = QedUtils::log_spaced_coord(
+                ctrl.chi_part_tem_min, ctrl.chi_part_tem_max,
+                ctrl.chi_part_tem_how_many, first_row);
+            slice_ctrl.chi_part_tem_max = QedUtils::log_spaced_coord(
+                ctrl.chi_part_tem_min, ctrl.chi_part_tem_max,
+                ctrl.chi_part_tem_how_many, first_row + how_many - 1);
+            slice_ctrl.chi_part_tem_how_many = how_many;
 
-    qs_engine.compute_dN_dt_lookup_table();
-    qs_engine.compute_cumulative_phot_em_table();
+            PicsarQuantumSynchrotronEngine qs_engine(
+                std::move(QedUtils::DummyStruct()), 1.0, slice_ctrl);
+            qs_engine.compute_cumulative_phot_em_table();
+            auto qs_innards_picsar = qs_engine.export_innards();
 
-    auto qs_innards_picsar = qs_engine.export_innards();
+            coords.assign(
+                qs_innards_picsar.cum_distrib_table_coords_1_ptr,
+                qs_innards_picsar.cum_distrib_table_coords_1_ptr +
+                qs_innards_picsar.cum_distrib_table_coords_1_how_many);
+            coords_2.assign(
+                qs_innards_picsar.cum_distrib_table_coords_2_ptr,
+                qs_innards_picsar.cum_distrib_table_coords_2_ptr +
+                qs_innards_picsar.cum_distrib_table_coords_2_how_many);
+            data.assign(
+                qs_innards_picsar.cum_distrib_table_data_ptr,
+                qs_innards_picsar.cum_distrib_table_data_ptr +
+                qs_innards_picsar.cum_distrib_table_data_how_many);
+        },
+        cum_distrib_coords_1, cum_distrib_data, cum_distrib_coords_2);
 
     //Copy data in a GPU-friendly data-structure
-    innards.ctrl = qs_innards_picsar.qs_ctrl;
-    innards.KKfunc_coords.assign(qs_innards_picsar.KKfunc_table_coords_ptr,
-        qs_innards_picsar.KKfunc_table_coords_ptr +
-        qs_innards_picsar.KKfunc_table_coords_how_many);
-    innards.KKfunc_data.assign(qs_innards_picsar.KKfunc_table_data_ptr,
-        qs_innards_picsar.KKfunc_table_data_ptr +
-        qs_innards_picsar.KKfunc_table_data_how_many);
-        innards.cum_distrib_coords_1.assign(
-    qs_innards_picsar.cum_distrib_table_coords_1_ptr,
-        qs_innards_picsar.cum_distrib_table_coords_1_ptr +
-        qs_innards_picsar.cum_distrib_table_coords_1_how_many);
+    innards.ctrl = ctrl;
+    innards.KKfunc_coords.assign(KKfunc_coords.begin(), KKfunc_coords.end());
+    innards.KKfunc_data.assign(KKfunc_data.begin(), KKfunc_data.end());
+    innards.cum_distrib_coords_1.assign(
+        cum_distrib_coords_1.begin(), cum_distrib_coords_1.end());
     innards.cum_distrib_coords_2.assign(
-        qs_innards_picsar.cum_distrib_table_coords_2_ptr,
-        qs_innards_picsar.cum_distrib_table_coords_2_ptr +
-        qs_innards_picsar.cum_distrib_table_coords_2_how_many);
+        cum_distrib_coords_2.begin(), cum_distrib_coords_2.end());
     innards.cum_distrib_data.assign(
-        qs_innards_picsar.cum_distrib_table_data_ptr,
-        qs_innards_picsar.cum_distrib_table_data_ptr +
-        qs_innards_picsar.cum_distrib_table_data_how_many);
+        cum_distrib_data.begin(), cum_distrib_data.end());
     //____
 }
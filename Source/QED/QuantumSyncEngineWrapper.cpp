@@ -9,6 +9,7 @@
 #include "QedTableParserHelperFunctions.H"
 #include "QuantumSyncDummyTable.H"
 
+#include <limits>
 #include <utility>
 
 using namespace std;
@@ -48,99 +49,200 @@ bool QuantumSynchrotronEngine::are_lookup_tables_initialized () const
     return m_lookup_tables_initialized;
 }
 
-bool
-QuantumSynchrotronEngine::init_lookup_tables_from_raw_data (
-    const Vector<char>& raw_data)
+tuple<bool, PicsarQuantumSynchrotronCtrl, const char*>
+QuantumSynchrotronEngine::parse_ctrl_from_raw_data (const char* p_data, const char* const p_last) const
 {
-    const char* p_data = raw_data.data();
-    const char* const p_last = &raw_data.back();
     bool is_ok;
+    auto ctrl = m_innards.ctrl;
 
-    //Header (control parameters)
-    tie(is_ok, m_innards.ctrl.chi_part_min, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_min)>(
+    tie(is_ok, ctrl.chi_part_min, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_min)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tdndt_min, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tdndt_min)>(
+    tie(is_ok, ctrl.chi_part_tdndt_min, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tdndt_min)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tdndt_max, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tdndt_max)>(
+    tie(is_ok, ctrl.chi_part_tdndt_max, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tdndt_max)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tdndt_how_many, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tdndt_how_many)>(
+    tie(is_ok, ctrl.chi_part_tdndt_how_many, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tdndt_how_many)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tem_min, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tem_min)>(
+    tie(is_ok, ctrl.chi_part_tem_min, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tem_min)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tem_max, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tem_max)>(
+    tie(is_ok, ctrl.chi_part_tem_max, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tem_max)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.chi_part_tem_how_many, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.chi_part_tem_how_many)>(
+    tie(is_ok, ctrl.chi_part_tem_how_many, p_data) =
+        parse_raw_data<decltype(ctrl.chi_part_tem_how_many)>(
             p_data, p_last);
-    if(!is_ok) return false;
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
 
-    tie(is_ok, m_innards.ctrl.prob_tem_how_many, p_data) =
-        parse_raw_data<decltype(m_innards.ctrl.prob_tem_how_many)>(
+    tie(is_ok, ctrl.prob_tem_how_many, p_data) =
+        parse_raw_data<decltype(ctrl.prob_tem_how_many)>(
             p_data, p_last);
+    if(!is_ok) return make_tuple(false, ctrl, nullptr);
+
+    //The sizes of the tables must be positive, and the size of the
+    //2D table must not overflow
+    if(ctrl.chi_part_tdndt_how_many == 0 || ctrl.chi_part_tem_how_many == 0 || ctrl.prob_tem_how_many == 0 ||
+       ctrl.prob_tem_how_many > std::numeric_limits<decltype(ctrl.prob_tem_how_many)>::max()/ctrl.chi_part_tem_how_many)
+        return make_tuple(false, ctrl, nullptr);
+
+    return make_tuple(true, ctrl, p_data);
+}
+
+bool
+QuantumSynchrotronEngine::init_lookup_tables_from_raw_data (
+    const Vector<char>& raw_data)
+{
+    if(raw_data.empty()) return false;
+    const char* p_data = raw_data.data();
+    const char* const p_last = &raw_data.back();
+    bool is_ok;
+
+    //Everything is parsed into local variables: the engine is only
+    //modified once the whole data have been parsed successfully
+
+    //Header (control parameters)
+    PicsarQuantumSynchrotronCtrl ctrl;
+    tie(is_ok, ctrl, p_data) = parse_ctrl_from_raw_data(p_data, p_last);
     if(!is_ok) return false;
 
     //___________________________
 
     //Data
-    Vector<Real> tndt_coords(m_innards.ctrl.chi_part_tdndt_how_many);
-    Vector<Real> tndt_data(m_innards.ctrl.chi_part_tdndt_how_many);
-    Vector<Real> cum_tab_coords1(m_innards.ctrl.chi_part_tem_how_many);
-    Vector<Real> cum_tab_coords2(m_innards.ctrl.prob_tem_how_many);
-    Vector<Real> cum_tab_data(m_innards.ctrl.chi_part_tem_how_many*
-        m_innards.ctrl.prob_tem_how_many);
+    Vector<Real> tndt_coords(ctrl.chi_part_tdndt_how_many);
+    Vector<Real> tndt_data(ctrl.chi_part_tdndt_how_many);
+    Vector<Real> cum_tab_coords1(ctrl.chi_part_tem_how_many);
+    Vector<Real> cum_tab_coords2(ctrl.prob_tem_how_many);
+    Vector<Real> cum_tab_data(ctrl.chi_part_tem_how_many*
+        ctrl.prob_tem_how_many);
 
     tie(is_ok, tndt_coords, p_data) =
         parse_raw_data_vec<Real>(
             p_data, tndt_coords.size(), p_last);
     if(!is_ok) return false;
-    m_innards.KKfunc_coords.assign(tndt_coords.begin(), tndt_coords.end());
 
     tie(is_ok, tndt_data, p_data) =
         parse_raw_data_vec<Real>(
             p_data, tndt_data.size(), p_last);
     if(!is_ok) return false;
-    m_innards.KKfunc_data.assign(tndt_data.begin(), tndt_data.end());
 
     tie(is_ok, cum_tab_coords1, p_data) =
         parse_raw_data_vec<Real>(
             p_data, cum_tab_coords1.size(), p_last);
     if(!is_ok) return false;
-    m_innards.cum_distrib_coords_1.assign(
-        cum_tab_coords1.begin(), cum_tab_coords1.end());
 
     tie(is_ok, cum_tab_coords2, p_data) =
         parse_raw_data_vec<Real>(
             p_data, cum_tab_coords2.size(), p_last);
     if(!is_ok) return false;
-    m_innards.cum_distrib_coords_2.assign(
-        cum_tab_coords2.begin(), cum_tab_coords2.end());
 
     tie(is_ok, cum_tab_data, p_data) =
         parse_raw_data_vec<Real>(
             p_data, cum_tab_data.size(), p_last);
     if(!is_ok) return false;
+
+    //___________________________
+    m_innards.ctrl = ctrl;
+    m_innards.KKfunc_coords.assign(tndt_coords.begin(), tndt_coords.end());
+    m_innards.KKfunc_data.assign(tndt_data.begin(), tndt_data.end());
+    m_innards.cum_distrib_coords_1.assign(
+        cum_tab_coords1.begin(), cum_tab_coords1.end());
+    m_innards.cum_distrib_coords_2.assign(
+        cum_tab_coords2.begin(), cum_tab_coords2.end());
     m_innards.cum_distrib_data.assign(
         cum_tab_data.begin(), cum_tab_data.end());
+    m_innards.mapped_file.reset();
+    m_lookup_tables_initialized = true;
+
+    return true;
+}
+
+bool
+QuantumSynchrotronEngine::init_lookup_tables_from_mapped_file (
+    const std::string& filename)
+{
+    auto mapped_file = make_shared<WarpXUtilIO::MappedFile>(filename);
+    if(mapped_file->size() == 0) return false;
+    const char* p_data = mapped_file->data();
+    const char* const p_last = p_data + mapped_file->size() - 1;
+    bool is_ok;
+
+    //Everything is parsed into local variables: the engine is only
+    //modified (and keeps the mapping alive) once the whole file has
+    //been parsed successfully
+
+    //Header (control parameters)
+    PicsarQuantumSynchrotronCtrl ctrl;
+    tie(is_ok, ctrl, p_data) = parse_ctrl_from_raw_data(p_data, p_last);
+    if(!is_ok) return false;
+
+    //Data (used in place, without copies)
+    const Real* p_tndt_coords;
+    tie(is_ok, p_tndt_coords, p_data) =
+        parse_raw_data_ptr<Real>(
+            p_data, ctrl.chi_part_tdndt_how_many, p_last);
+    if(!is_ok) return false;
+
+    const Real* p_tndt_data;
+    tie(is_ok, p_tndt_data, p_data) =
+        parse_raw_data_ptr<Real>(
+            p_data, ctrl.chi_part_tdndt_how_many, p_last);
+    if(!is_ok) return false;
+
+    const Real* p_cum_tab_coords1;
+    tie(is_ok, p_cum_tab_coords1, p_data) =
+        parse_raw_data_ptr<Real>(
+            p_data, ctrl.chi_part_tem_how_many, p_last);
+    if(!is_ok) return false;
+
+    const Real* p_cum_tab_coords2;
+    tie(is_ok, p_cum_tab_coords2, p_data) =
+        parse_raw_data_ptr<Real>(
+            p_data, ctrl.prob_tem_how_many, p_last);
+    if(!is_ok) return false;
+
+    const Real* p_cum_tab_data;
+    tie(is_ok, p_cum_tab_data, p_data) =
+        parse_raw_data_ptr<Real>(
+            p_data, ctrl.chi_part_tem_how_many*ctrl.prob_tem_how_many, p_last);
+    if(!is_ok) return false;
 
     //___________________________
+    m_innards.ctrl = ctrl;
+    m_innards.mapped_KKfunc_coords = p_tndt_coords;
+    m_innards.mapped_KKfunc_data = p_tndt_data;
+    m_innards.mapped_cum_distrib_coords_1 = p_cum_tab_coords1;
+    m_innards.mapped_cum_distrib_coords_2 = p_cum_tab_coords2;
+    m_innards.mapped_cum_distrib_data = p_cum_tab_data;
+
+    //The vectors are not used: free their memory
+    m_innards.KKfunc_coords.clear();
+    m_innards.KKfunc_coords.shrink_to_fit();
+    m_innards.KKfunc_data.clear();
+    m_innards.KKfunc_data.shrink_to_fit();
+    m_innards.cum_distrib_coords_1.clear();
+    m_innards.cum_distrib_coords_1.shrink_to_fit();
+    m_innards.cum_distrib_coords_2.clear();
+    m_innards.cum_distrib_coords_2.shrink_to_fit();
+    m_innards.cum_distrib_data.clear();
+    m_innards.cum_distrib_data.shrink_to_fit();
+
+    m_innards.mapped_file = mapped_file;
     m_lookup_tables_initialized = true;
 
     return true;
@@ -165,6 +267,7 @@ void QuantumSynchrotronEngine::init_dummy_tables()
         QedUtils::QuantumSyncEngineInnardsDummy.cum_distrib_data.begin(),
         QedUtils::QuantumSyncEngineInnardsDummy.cum_distrib_data.end());
 
+    m_innards.mapped_file.reset();
     m_lookup_tables_initialized = true;
 }
 
@@ -175,14 +278,13 @@ Vector<char> QuantumSynchrotronEngine::export_lookup_tables_data () const
     if(!m_lookup_tables_initialized)
         return res;
 
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_min, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tdndt_min, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tdndt_max, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tdndt_how_many, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tem_min, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tem_max, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.chi_part_tem_how_many, 1, res);
-    add_data_to_vector_char(&m_innards.ctrl.prob_tem_how_many, 1, res);
+    if(m_innards.mapped_file){
+        res.assign(m_innards.mapped_file->data(),
+            m_innards.mapped_file->data() + m_innards.mapped_file->size());
+        return res;
+    }
+
+    res = export_ctrl_data(m_innards.ctrl);
 
     add_data_to_vector_char(m_innards.KKfunc_coords.data(),
         m_innards.KKfunc_coords.size(), res);
@@ -198,6 +300,22 @@ Vector<char> QuantumSynchrotronEngine::export_lookup_tables_data () const
     return res;
 }
 
+Vector<char> QuantumSynchrotronEngine::export_ctrl_data (const PicsarQuantumSynchrotronCtrl& ctrl)
+{
+    Vector<char> res{};
+
+    add_data_to_vector_char(&ctrl.chi_part_min, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tdndt_min, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tdndt_max, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tdndt_how_many, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tem_min, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tem_max, 1, res);
+    add_data_to_vector_char(&ctrl.chi_part_tem_how_many, 1, res);
+    add_data_to_vector_char(&ctrl.prob_tem_how_many, 1, res);
+
+    return res;
+}
+
 PicsarQuantumSynchrotronCtrl
 QuantumSynchrotronEngine::get_default_ctrl() const
 {
@@ -215,6 +333,7 @@ void QuantumSynchrotronEngine::compute_lookup_tables (
 {
 #ifdef WARPX_QED_TABLE_GEN
     m_table_builder.compute_table(ctrl, m_innards);
+    m_innards.mapped_file.reset();
     m_lookup_tables_initialized = true;
 #endif
 }
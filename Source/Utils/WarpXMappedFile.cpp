@@ -0,0 +1,44 @@
+/* Copyright 2020
+ *
+ * This file is part of WarpX.
+ *
+ * License: BSD-3-Clause-LBNL
+ */
+#include "WarpXMappedFile.H"
+
+#include <AMReX.H>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace WarpXUtilIO;
+
+MappedFile::MappedFile (const std::string& filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        amrex::Abort("Cannot open " + filename);
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0){
+        close(fd);
+        amrex::Abort("Cannot read the size of " + filename);
+    }
+    m_size = file_stat.st_size;
+
+    void* addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping remains valid after the file descriptor is closed
+    close(fd);
+    if(addr == MAP_FAILED)
+        amrex::Abort("Cannot map " + filename + " in memory");
+
+    m_data = static_cast<const char*>(addr);
+}
+
+MappedFile::~MappedFile ()
+{
+    if(m_data != nullptr)
+        munmap(const_cast<char*>(m_data), m_size);
+}
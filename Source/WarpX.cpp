@@ -15,6 +15,8 @@
 #include <WarpXUtil.H>
 #include <WarpXAlgorithmSelection.H>
 #include <WarpX_FDTD.H>
+#include <SliceDiagnostic.H>
+#include <FieldCompression.H>
 
 #include <AMReX_ParmParse.H>
 #include <AMReX_MultiFabUtil.H>
@@ -86,6 +88,9 @@ int WarpX::num_mirrors = 0;
 
 int  WarpX::sort_int = -1;
 
+bool WarpX::use_counter_rng = false;
+long WarpX::random_seed = 0;
+
 bool WarpX::do_back_transformed_diagnostics = false;
 std::string WarpX::lab_data_directory = "lab_frame_data";
 int  WarpX::num_snapshots_lab = std::numeric_limits<int>::lowest();
@@ -164,7 +169,8 @@ WarpX::WarpX ()
     ReadParameters();
 
 #ifdef WARPX_USE_OPENPMD
-    m_OpenPMDPlotWriter = new WarpXOpenPMDPlot(openpmd_tspf, openpmd_backend, WarpX::getPMLdirections());
+    m_OpenPMDPlotWriter = new WarpXOpenPMDPlot(openpmd_tspf, openpmd_backend, WarpX::getPMLdirections(),
+                                               openpmd_async);
 #endif
 
     // Geometry on all levels has been defined already.
@@ -459,6 +465,8 @@ WarpX::ReadParameters ()
         pp.query("n_field_gather_buffer", n_field_gather_buffer);
         pp.query("n_current_deposition_buffer", n_current_deposition_buffer);
         pp.query("sort_int", sort_int);
+        pp.query("use_counter_rng", use_counter_rng);
+        pp.query("random_seed", random_seed);
 
         double quantum_xi;
         int quantum_xi_is_specified = pp.query("quantum_xi", quantum_xi);
@@ -495,11 +503,25 @@ WarpX::ReadParameters ()
         pp.query("openpmd_backend", openpmd_backend);
 #ifdef WARPX_USE_OPENPMD
         pp.query("openpmd_tspf", openpmd_tspf);
+        pp.query("openpmd_async", openpmd_async);
 #endif
         pp.query("plot_costs", plot_costs);
         pp.query("plot_raw_fields", plot_raw_fields);
         pp.query("plot_raw_fields_guards", plot_raw_fields_guards);
         pp.query("plot_coarsening_ratio", plot_coarsening_ratio);
+        pp.queryarr("plot_region_lo", plot_region_lo);
+        pp.queryarr("plot_region_hi", plot_region_hi);
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(
+            plot_region_lo.size() == plot_region_hi.size(),
+            "warpx.plot_region_lo and warpx.plot_region_hi should be given together");
+        if (!plot_region_lo.empty()) {
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(plot_region_lo.size() == AMREX_SPACEDIM,
+                "warpx.plot_region_lo and warpx.plot_region_hi should have one value per dimension");
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                AMREX_ALWAYS_ASSERT_WITH_MESSAGE(plot_region_lo[idim] < plot_region_hi[idim],
+                    "warpx.plot_region_lo should be smaller than warpx.plot_region_hi");
+            }
+        }
         bool user_fields_to_plot;
         user_fields_to_plot = pp.queryarr("fields_to_plot", fields_to_plot);
         if (not user_fields_to_plot){
@@ -508,6 +530,7 @@ WarpX::ReadParameters ()
                               "Bz", "jx", "jy", "jz",
                               "part_per_cell"};
         }
+        m_field_compression = std::make_unique<FieldCompression>();
         // set plot_rho to true of the users requests it, so that
         // rho is computed at each iteration.
         if (std::find(fields_to_plot.begin(), fields_to_plot.end(), "rho")
@@ -530,8 +553,10 @@ WarpX::ReadParameters ()
         }
 
         // Check that the coarsening_ratio can divide the blocking factor
+        // (of all the levels, the finest one included, since all of them
+        // are coarsened by GetFieldOutputLayout)
         const int nlevs_max = maxLevel();
-        for (int lev=0; lev<nlevs_max; lev++){
+        for (int lev=0; lev<=nlevs_max; lev++){
           for (int comp=0; comp<AMREX_SPACEDIM; comp++){
             if ( blockingFactor(lev)[comp] % plot_coarsening_ratio != 0 ){
               amrex::Abort("plot_coarsening_ratio should be an integer "
@@ -0,0 +1,135 @@
+# Copyright 2020
+#
+# This file is part of WarpX.
+#
+# License: BSD-3-Clause-LBNL
+
+from glob import glob
+import numpy as np
+
+def read_compressed_fields(plt_file):
+    '''
+
+    This function reads the fields written with lossy compression
+    (see the parameter compression.fields) in a WarpX plt file, and
+    decodes them. The decoded values differ from the simulation values
+    by at most the tolerance of each field.
+
+    Arguments:
+
+        plt_file : An AMReX plt_file file. Must contain a compressed_fields directory.
+
+    Returns:
+
+        A list of dictionaries where the keys are field name strings and the values
+        are numpy arrays covering the output domain of the level (in the same order
+        as the indices, e.g. data['Ex'][ix, iz] in 2D). Each entry in the list
+        corresponds to a different level. Cells not covered by a box are NaN.
+        Also returns a dictionary with the time and the physical domain of each level.
+
+    Example:
+
+        >>> data, info = read_compressed_fields("plt00016")
+        >>> print(data[0].keys())
+        >>> print(data[0]['Ex'].shape)
+
+    '''
+    header = _read_header(plt_file + "/compressed_fields/Header")
+    dim = header['dim']
+    field_names = header['field_names']
+
+    all_data = []
+    for lev, level_info in enumerate(header['levels']):
+        dom_lo = level_info['lo']
+        shape = tuple(level_info['hi'] - dom_lo + 1)
+        data = {}
+        for field in field_names:
+            data[field] = np.full(shape, np.nan)
+
+        data_files = glob(plt_file + "/compressed_fields/Level_%d/Data_*" % lev)
+        for data_file in data_files:
+            with open(data_file, "rb") as f:
+                content = f.read()
+            pos = 0
+            while pos < len(content):
+                corners = np.frombuffer(content, dtype='<i4', count=2*dim, offset=pos)
+                pos += 4*2*dim
+                lo = corners[:dim] - dom_lo
+                hi = corners[dim:] - dom_lo
+                box_shape = tuple(hi - lo + 1)
+                box_slice = tuple(slice(l, h+1) for l, h in zip(lo, hi))
+                for field, step in zip(field_names, level_info['steps']):
+                    nbytes = int(np.frombuffer(content, dtype='<u8', count=1, offset=pos)[0])
+                    pos += 8
+                    values = _decode(content[pos:pos+nbytes], np.prod(box_shape), step)
+                    pos += nbytes
+                    # The values are stored in Fortran order
+                    data[field][box_slice] = values.reshape(box_shape, order='F')
+        all_data.append(data)
+
+    info = {'time' : header['time'],
+            'prob_lo' : [level['prob_lo'] for level in header['levels']],
+            'prob_hi' : [level['prob_hi'] for level in header['levels']]}
+    return all_data, info
+
+
+def _read_header(header_file):
+    with open(header_file, "r") as f:
+        version = f.readline().strip()
+        assert version == "WarpX-compressed-fields-1", "Unknown format: " + version
+        time = float(f.readline())
+        dim = int(f.readline())
+        nlevels = int(f.readline())
+        nfields = int(f.readline())
+        field_names = f.readline().split()
+        assert len(field_names) == nfields
+        levels = []
+        for lev in range(nlevels):
+            corners = np.array([int(v) for v in f.readline().split()], dtype=np.int64)
+            prob_lo = np.array([float(v) for v in f.readline().split()])
+            prob_hi = np.array([float(v) for v in f.readline().split()])
+            steps = [float(v) for v in f.readline().split()]
+            levels.append({'lo' : corners[:dim],
+                           'hi' : corners[dim:],
+                           'prob_lo' : prob_lo,
+                           'prob_hi' : prob_hi,
+                           'steps' : steps})
+    return {'time' : time,
+            'dim' : dim,
+            'field_names' : field_names,
+            'levels' : levels}
+
+
+def _decode(encoded, n, step):
+    '''
+    Decode the n values encoded with the quantization step `step`:
+    the stream contains the zigzag-encoded, variable-length quantized
+    residuals, where a 0 is followed by the length of a run of zeros minus 1.
+    '''
+    q = np.zeros(n, dtype=np.int64)
+    i = 0
+    pos = 0
+    nbytes = len(encoded)
+    while pos < nbytes:
+        value, pos = _read_varint(encoded, pos)
+        if value == 0:
+            run, pos = _read_varint(encoded, pos)
+            i += run + 1
+        else:
+            q[i] = (value >> 1) ^ -(value & 1)
+            i += 1
+    assert i == n, "Corrupted compressed field data"
+    # Same sequence of floating-point operations as in the encoder
+    return np.cumsum(q.astype(np.float64)*step)
+
+
+def _read_varint(encoded, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = encoded[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7